@@ -36,11 +36,18 @@ Links:
 #include <vector>
 #include <string>
 #include <algorithm>
+#include <fstream>
+#include <chrono>
 #include <cstdint>
 
 #include <SDL2/SDL.h>
 
+#include <utils/string_format.hpp>
+#include <utils/ThreadPool.hpp>
 #include <nes/Bus.hpp>
+#include <nes/Batch.hpp>
+#include <nes/Rewind.hpp>
+#include <nes/RunAhead.hpp>
 #include <nes/cpu/CPU2A03.hpp>
 #include <nes/ram/Ram.hpp>
 #include <nes/ppu/PPU2C02SDL.hpp>
@@ -120,20 +127,104 @@ public:
                 if (rom_start_address < 0x0000 || rom_start_address > 0xFFFF) {
                     throw std::runtime_error("Rom start address must be between 0x0000 - 0xFFFF");
                 }
+            } else if (key == "-d") {
+                std::string value(argv[argn + 1]);
+                if (value.size() > 0) {
+                    database_filename = value;
+                } else {
+                    throw std::runtime_error("ROM database filename must not be blank");
+                }
+            } else if (key == "-m") {
+                memory_map = true;
+                // Decrement the argement number because this argement doesn't take a value
+                argn--;
             } else if (key == "-x") {
                 headless = true;
                 // Decrement the argement number because this argement doesn't take a value
                 argn--;
+            } else if (key == "-H") {
+                print_hashes = true;
+                // Decrement the argement number because this argement doesn't take a value
+                argn--;
+            } else if (key == "-n") {
+                std::string value(argv[argn + 1]);
+                if (value.size() > 0) {
+                    max_frames = std::stoul(value);
+                } else {
+                    throw std::runtime_error("Frame count must not be blank");
+                }
+            } else if (key == "-w") {
+                std::string value(argv[argn + 1]);
+                if (value.size() > 0) {
+                    wav_filename = value;
+                } else {
+                    throw std::runtime_error("WAV filename must not be blank");
+                }
+            } else if (key == "-r") {
+                std::string value(argv[argn + 1]);
+                if (value.size() > 0) {
+                    run_ahead_frames = std::stoul(value);
+                } else {
+                    throw std::runtime_error("Run-ahead frame count must not be blank");
+                }
+            } else if (key == "-R") {
+                std::string value(argv[argn + 1]);
+                if (value.size() > 0) {
+                    rewind_megabytes = std::stoul(value);
+                } else {
+                    throw std::runtime_error("Rewind buffer size must not be blank");
+                }
+            } else if (key == "-b") {
+                std::string value(argv[argn + 1]);
+                if (value.size() > 0) {
+                    batch_filename = value;
+                } else {
+                    throw std::runtime_error("Batch manifest filename must not be blank");
+                }
+            } else if (key == "-j") {
+                std::string value(argv[argn + 1]);
+                if (value.size() > 0) {
+                    threads = std::stoul(value);
+                } else {
+                    throw std::runtime_error("Thread count must not be blank");
+                }
+            } else if (key == "-o") {
+                std::string value(argv[argn + 1]);
+                if (value.size() > 0) {
+                    results_filename = value;
+                } else {
+                    throw std::runtime_error("Results filename must not be blank");
+                }
+            } else if (key == "-D") {
+                std::string value(argv[argn + 1]);
+                if (value.size() > 0) {
+                    database_csv_filename = value;
+                } else {
+                    throw std::runtime_error("ROM list filename must not be blank");
+                }
             } else if (key == "-h") {
                 std::cout << argv[0] << " (-f NES-ROM.nes | -s \"ROM BYTES\" -a $CODE-START)" << std::endl;
                 std::cout << "  Start the Nintendo Entertainment System emulator with an NES ROM file:" << std::endl;
-                std::cout << "    -f NES-ROM.nes - Path to iNES1 or iNES2 ROM file." << std::endl;
+                std::cout << "    -f NES-ROM.nes - Path to iNES1 or iNES2 ROM file, optionally gzipped or in a zip." << std::endl;
                 std::cout << "  or with a string of bytes in hex separated by spaces that make up the rom:" << std::endl;
                 std::cout << "    -s \"ROM BYTES\" - Space separated byte values in HEX that make up the rom." << std::endl;
                 std::cout << "  Additional options:" << std::endl;
                 std::cout << "    -h - Display this help." << std::endl;
                 std::cout << "    -a $CODE-START - 16bit address for the start of code execution vs reading from 0xFFFC." << std::endl;
+                std::cout << "    -d ROMS.db - ROM database used to correct bad headers." << std::endl;
+                std::cout << "    -m - Memory map the ROM file instead of reading it in." << std::endl;
                 std::cout << "    -x - Run headless (no graphics or sound) for debugging." << std::endl;
+                std::cout << "    -n FRAMES - Stop after running this many frames." << std::endl;
+                std::cout << "    -H - When headless, print the video and per channel audio hashes of every frame." << std::endl;
+                std::cout << "    -w AUDIO.wav - When headless, capture the audio output to a WAV file." << std::endl;
+                std::cout << "    -r FRAMES - Run this many frames ahead to hide the game's input lag." << std::endl;
+                std::cout << "    -R MB - Keep this many megabytes of rewind history, hold backspace to rewind." << std::endl;
+                std::cout << "  or run a batch of headless jobs across every core and exit:" << std::endl;
+                std::cout << "    -b JOBS.txt - Manifest with a \"ROM MOVIE.fm2 FRAMES\" line per job (MOVIE - for no input, FRAMES 0 for the whole movie)." << std::endl;
+                std::cout << "    -j THREADS - Worker threads for the batch, one per core by default." << std::endl;
+                std::cout << "    -o RESULTS.csv - Write the batch results here instead of to stdout." << std::endl;
+                std::cout << "  or build a ROM database for -d and exit:" << std::endl;
+                std::cout << "    -D ROMS.csv -o ROMS.db - One \"CRC32,MAPPER,SUB_MAPPER,MIRRORING,TIMING,PRG_RAM,PRG_NVRAM,CHR_RAM,CHR_NVRAM\" line per ROM." << std::endl;
                 exit(0);
             }
         }
@@ -146,14 +237,89 @@ public:
     }
 
     std::vector<uint8_t> rom;
-    int32_t rom_start_address;
+    int32_t rom_start_address = 0;
     std::string rom_filename;
-    bool headless;
+    bool memory_map = false;
+    std::string database_filename;
+    bool headless = false;
+    uint32_t max_frames = 0;
+    std::string wav_filename;
+    bool print_hashes = false;
+    uint32_t rewind_megabytes = 0;
+    uint32_t run_ahead_frames = 0;
+    std::string batch_filename;
+    uint32_t threads = 0;
+    std::string results_filename;
+    std::string database_csv_filename;
 };
 
+// Player 1 on the keyboard
+uint8_t keyboard_buttons() {
+    const Uint8 *keys = SDL_GetKeyboardState(NULL);
+    uint8_t buttons = 0x00;
+    buttons |= keys[SDL_SCANCODE_X] ? nes::controller::Controller::BUTTON_A : 0x00;
+    buttons |= keys[SDL_SCANCODE_Z] ? nes::controller::Controller::BUTTON_B : 0x00;
+    buttons |= keys[SDL_SCANCODE_RSHIFT] ? nes::controller::Controller::BUTTON_SELECT : 0x00;
+    buttons |= keys[SDL_SCANCODE_RETURN] ? nes::controller::Controller::BUTTON_START : 0x00;
+    buttons |= keys[SDL_SCANCODE_UP] ? nes::controller::Controller::BUTTON_UP : 0x00;
+    buttons |= keys[SDL_SCANCODE_DOWN] ? nes::controller::Controller::BUTTON_DOWN : 0x00;
+    buttons |= keys[SDL_SCANCODE_LEFT] ? nes::controller::Controller::BUTTON_LEFT : 0x00;
+    buttons |= keys[SDL_SCANCODE_RIGHT] ? nes::controller::Controller::BUTTON_RIGHT : 0x00;
+    return buttons;
+}
+
+// Returns the exit code, non zero if any job failed
+int run_batch(const Options &options) {
+    auto database = (
+        options.database_filename.size() > 0 ?
+        std::make_shared<const nes::cart::RomDatabase>(options.database_filename) :
+        nullptr
+    );
+    nes::Batch batch(options.batch_filename, database);
+    utils::ThreadPool pool(options.threads);
+
+    const auto start = std::chrono::steady_clock::now();
+    batch.run(pool);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (options.results_filename.size() > 0) {
+        std::ofstream results(options.results_filename);
+        if (!results) {
+            throw std::runtime_error(utils::string_format("Unable to write results to %s", options.results_filename.c_str()));
+        }
+        batch.write_csv(results);
+    } else {
+        batch.write_csv(std::cout);
+    }
+
+    uint64_t frames = 0;
+    for (const auto &result : batch.results()) {
+        frames += result.frames;
+    }
+    std::cerr << utils::string_format(
+        "%zu jobs (%zu failed), %llu frames in %.1fs on %zu threads, %.0f frames/s",
+        batch.jobs().size(), batch.failures(), (unsigned long long)frames, seconds, pool.size(), frames / std::max(seconds, 0.001)
+    ) << std::endl;
+    return batch.failures() > 0 ? 1 : 0;
+}
+
 int main(int argc, char **argv) {
     Options options(argc, argv);
 
+    if (options.database_csv_filename.size() > 0) {
+        if (options.results_filename.size() <= 0) {
+            throw std::runtime_error("Building a ROM database needs an output file (-o)");
+        }
+        const auto records = nes::cart::RomDatabase::read_csv(options.database_csv_filename);
+        nes::cart::RomDatabase::write(options.results_filename, records);
+        std::cout << utils::string_format("Wrote %zu ROMs to %s", records.size(), options.results_filename.c_str()) << std::endl;
+        return 0;
+    }
+
+    if (options.batch_filename.size() > 0) {
+        return run_batch(options);
+    }
+
     if (!options.headless) {
         SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO | SDL_INIT_JOYSTICK);
 
@@ -190,7 +356,11 @@ int main(int argc, char **argv) {
     auto apu = (
         !options.headless ?
         (std::shared_ptr<nes::apu::APURP2A03>)std::make_shared<nes::apu::APURP2A03SDL>() :
-        (std::shared_ptr<nes::apu::APURP2A03>)std::make_shared<nes::apu::APURP2A03Headless>()
+        (
+            options.wav_filename.size() > 0 ?
+            (std::shared_ptr<nes::apu::APURP2A03>)std::make_shared<nes::apu::APURP2A03Headless>(options.wav_filename) :
+            (std::shared_ptr<nes::apu::APURP2A03>)std::make_shared<nes::apu::APURP2A03Headless>()
+        )
     );
     auto controller = std::make_shared<nes::controller::Controller>();
 
@@ -198,9 +368,14 @@ int main(int argc, char **argv) {
 
     cpu->connect_bus(bus);
 
+    auto database = (
+        options.database_filename.size() > 0 ?
+        std::make_shared<const nes::cart::RomDatabase>(options.database_filename) :
+        nullptr
+    );
     auto cart = (
         options.rom_filename.size() > 0 ?
-        std::make_shared<nes::cart::Cart>(options.rom_filename) :
+        std::make_shared<nes::cart::Cart>(options.rom_filename, options.memory_map, database) :
         std::make_shared<nes::cart::Cart>(options.rom)
     );
     std::cout << *cart << std::endl;
@@ -213,7 +388,29 @@ int main(int argc, char **argv) {
 
     bus->reset();
 
+    // Only set when printing hashes
+    std::shared_ptr<nes::ppu::PPU2C02Headless> headless_ppu;
+    std::shared_ptr<nes::apu::APURP2A03Headless> headless_apu;
+    if (options.headless && options.print_hashes) {
+        headless_ppu = std::dynamic_pointer_cast<nes::ppu::PPU2C02Headless>(ppu);
+        headless_apu = std::dynamic_pointer_cast<nes::apu::APURP2A03Headless>(apu);
+    }
+
+    // Only set when rewinding
+    std::unique_ptr<nes::Rewind> rewind;
+    std::vector<uint8_t> rewind_state;
+    if (!options.headless && options.rewind_megabytes > 0) {
+        rewind = std::make_unique<nes::Rewind>((size_t)options.rewind_megabytes * 1024 * 1024);
+    }
+
+    // Only set when running ahead
+    std::unique_ptr<nes::RunAhead> run_ahead;
+    if (options.run_ahead_frames > 0) {
+        run_ahead = std::make_unique<nes::RunAhead>(bus, options.run_ahead_frames);
+    }
+
     bool done = false;
+    uint32_t frame_count = 0;
     while (!done) {
         if (!options.headless) {
             SDL_Event event;
@@ -232,10 +429,56 @@ int main(int argc, char **argv) {
         }
 
         if (!done) {
-            bus->clock();
+            // Run-ahead works a whole frame at a time
+            if (run_ahead != nullptr) {
+                run_ahead->run_frame();
+            } else {
+                bus->clock();
+            }
+
+            if (ppu->frame_complete()) {
+                if (!options.headless) {
+                    controller->set_buttons(0, keyboard_buttons());
+                }
+
+                if (rewind != nullptr) {
+                    if (SDL_GetKeyboardState(NULL)[SDL_SCANCODE_BACKSPACE]) {
+                        if (rewind->step_back(rewind_state)) {
+                            bus->load_state(rewind_state);
+                        }
+                    } else {
+                        bus->save_state(rewind_state);
+                        rewind->push(rewind_state);
+                    }
+                }
+
+                if (headless_ppu != nullptr && headless_apu != nullptr) {
+                    const auto &audio = headless_apu->frame_hashes();
+                    std::cout << utils::string_format(
+                        "frame %u video=%016llX pulse1=%016llX pulse2=%016llX triangle=%016llX noise=%016llX dmc=%016llX",
+                        frame_count, (unsigned long long)headless_ppu->frame_hash(),
+                        (unsigned long long)audio.pulse1, (unsigned long long)audio.pulse2, (unsigned long long)audio.triangle,
+                        (unsigned long long)audio.noise, (unsigned long long)audio.dmc
+                    ) << std::endl;
+                }
+
+                frame_count++;
+                if (options.max_frames > 0 && frame_count >= options.max_frames) {
+                    done = true;
+                }
+            }
         }
     }
 
+    // Make sure the game is saved even if the cart outlives main
+    cart->sync_battery_ram();
+
+    // Drop our references so every component is torn down (and capture files
+    // are finished) before exiting
+    bus.reset();
+    headless_apu.reset();
+    apu.reset();
+
     if (!options.headless) {
         SDL_DestroyRenderer(renderer);
         SDL_DestroyWindow(window);
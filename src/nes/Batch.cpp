@@ -0,0 +1,203 @@
+/*******************************************************************************
+MIT License
+
+Copyright (c) 2020 Chris Luby
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+/*******************************************************************************
+Batch runner for regression suites
+*******************************************************************************/
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <memory>
+#include <fstream>
+#include <sstream>
+#include <ostream>
+#include <chrono>
+#include <algorithm>
+#include <stdexcept>
+
+#include <utils/string_format.hpp>
+#include <utils/fnv1a.hpp>
+#include <utils/ThreadPool.hpp>
+#include <nes/Batch.hpp>
+#include <nes/Bus.hpp>
+#include <nes/Movie.hpp>
+#include <nes/ppu/PPU2C02Headless.hpp>
+#include <nes/apu/APURP2A03Headless.hpp>
+#include <nes/cart/Cart.hpp>
+
+namespace nes {
+
+namespace {
+
+// Relative to the directory of the manifest
+std::string resolve(const std::string &manifest_filename, const std::string &filename) {
+    const bool absolute = filename[0] == '/' || filename[0] == '\\' || (filename.size() > 1 && filename[1] == ':');
+    const size_t slash = manifest_filename.find_last_of("/\\");
+    if (absolute || slash == std::string::npos) {
+        return filename;
+    }
+    return manifest_filename.substr(0, slash + 1) + filename;
+}
+
+std::string csv_field(const std::string &value) {
+    if (value.find_first_of(",\"\r\n") == std::string::npos) {
+        return value;
+    }
+    std::string quoted = "\"";
+    for (const char c : value) {
+        quoted += c;
+        if (c == '"') {
+            quoted += '"';
+        }
+    }
+    return quoted + "\"";
+}
+
+} // anonymous
+
+Batch::Batch(const std::string &manifest_filename, std::shared_ptr<const nes::cart::RomDatabase> database)
+    : m_database(database) {
+    std::ifstream file(manifest_filename);
+    if (!file) {
+        throw std::runtime_error(utils::string_format("Unable to open batch manifest %s", manifest_filename.c_str()));
+    }
+
+    std::string line;
+    uint32_t line_number = 0;
+    while (std::getline(file, line)) {
+        line_number++;
+        std::istringstream fields(line);
+        std::string rom_filename;
+        if (!(fields >> rom_filename) || rom_filename[0] == '#') {
+            continue;
+        }
+        std::string movie_filename;
+        int64_t frames = -1;
+        if (!(fields >> movie_filename >> frames) || frames < 0 || frames > UINT32_MAX) {
+            throw std::runtime_error(utils::string_format("%s:%u expected ROM MOVIE FRAMES", manifest_filename.c_str(), line_number));
+        }
+        if (movie_filename == "-" && frames == 0) {
+            throw std::runtime_error(utils::string_format("%s:%u needs a frame count without a movie", manifest_filename.c_str(), line_number));
+        }
+        m_jobs.push_back({
+            resolve(manifest_filename, rom_filename),
+            movie_filename != "-" ? resolve(manifest_filename, movie_filename) : std::string(),
+            (uint32_t)frames
+        });
+    }
+}
+
+void Batch::run(utils::ThreadPool &pool) {
+    m_results.assign(m_jobs.size(), Result());
+
+    // Longest first so one big job doesn't start last and hold everything up,
+    // the pool starts outside submits in order on every worker.  Whole movies
+    // aren't read until they run, guess they're long.
+    std::vector<size_t> order(m_jobs.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [this](const size_t a, const size_t b) {
+        const uint32_t a_frames = m_jobs[a].frames > 0 ? m_jobs[a].frames : UINT32_MAX;
+        const uint32_t b_frames = m_jobs[b].frames > 0 ? m_jobs[b].frames : UINT32_MAX;
+        return a_frames > b_frames;
+    });
+
+    for (const size_t index : order) {
+        pool.submit([this, index] {
+            m_results[index] = run_job(m_jobs[index], m_database);
+        });
+    }
+    pool.wait();
+}
+
+const size_t Batch::failures() const {
+    return std::count_if(m_results.begin(), m_results.end(), [](const Result &result) {
+        return !result.error.empty();
+    });
+}
+
+void Batch::write_csv(std::ostream &os) const {
+    os << "rom,movie,frames,video_hash,run_hash,milliseconds,error" << std::endl;
+    for (size_t i = 0; i < m_jobs.size() && i < m_results.size(); i++) {
+        const Job &job = m_jobs[i];
+        const Result &result = m_results[i];
+        os << csv_field(job.rom_filename) << ',' << csv_field(job.movie_filename) << ',' << utils::string_format(
+            "%u,%016llX,%016llX,%.3f,",
+            result.frames, (unsigned long long)result.video_hash, (unsigned long long)result.run_hash, result.milliseconds
+        ) << csv_field(result.error) << std::endl;
+    }
+}
+
+Batch::Result Batch::run_job(const Job &job, std::shared_ptr<const nes::cart::RomDatabase> database) {
+    const auto start = std::chrono::steady_clock::now();
+    Result result = {};
+
+    try {
+        std::unique_ptr<Movie> movie;
+        if (!job.movie_filename.empty()) {
+            movie = std::make_unique<Movie>(job.movie_filename);
+        }
+        const uint32_t frames = job.frames > 0 ? job.frames : movie->frames();
+
+        auto cpu = std::make_shared<nes::cpu::CPU2A03>();
+        auto ppu = std::make_shared<nes::ppu::PPU2C02Headless>();
+        auto apu = std::make_shared<nes::apu::APURP2A03Headless>();
+        auto controller = std::make_shared<nes::controller::Controller>();
+        auto bus = std::make_shared<nes::Bus>(cpu, std::make_shared<nes::ram::Ram>(), ppu, apu, controller);
+        cpu->connect_bus(bus);
+        bus->load_cart(std::make_shared<nes::cart::Cart>(job.rom_filename, false, database, false));
+
+        uint64_t run_hash = utils::FNV1A_64_OFFSET;
+        for (uint32_t frame = 0; frame < frames; frame++) {
+            if (movie != nullptr) {
+                if (movie->reset(frame)) {
+                    bus->reset();
+                }
+                for (uint8_t port = 0; port < Movie::NUM_PORTS; port++) {
+                    controller->set_buttons(port, movie->buttons(frame, port));
+                }
+            }
+            bus->run_frame();
+
+            const uint64_t video_hash = ppu->frame_hash();
+            const auto &audio = apu->frame_hashes();
+            run_hash = utils::fnv1a_64(&video_hash, sizeof(video_hash), run_hash);
+            run_hash = utils::fnv1a_64(&audio, sizeof(audio), run_hash);
+        }
+
+        result.frames = frames;
+        result.video_hash = ppu->frame_hash();
+        result.run_hash = run_hash;
+    } catch (const std::exception &e) {
+        result.error = e.what();
+    }
+
+    result.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+} // nes
@@ -0,0 +1,94 @@
+/*******************************************************************************
+MIT License
+
+Copyright (c) 2020 Chris Luby
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+/*******************************************************************************
+Batch runner for regression suites.  A manifest lists jobs, one per line:
+  ROM MOVIE FRAMES
+where MOVIE is an FM2 input movie or - for no input, and a FRAMES of 0 runs to
+the end of the movie.  Blank lines and lines starting with # are skipped, and
+relative paths are from the manifest's directory.
+
+Every job gets its own headless machine and runs as one task on a work-stealing
+pool, longest first, collecting a hash of every frame's video and audio and the
+time it took.  Battery RAM is never loaded or saved so reruns give the same
+hashes.
+*******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <memory>
+#include <ostream>
+
+#include <utils/ThreadPool.hpp>
+#include <nes/cart/RomDatabase.hpp>
+
+namespace nes {
+
+class Batch {
+public:
+    struct Job {
+        std::string rom_filename;
+        std::string movie_filename; // Empty for no input
+        uint32_t frames; // 0 to run the whole movie
+    };
+
+    struct Result {
+        uint32_t frames; // Frames actually run
+        uint64_t video_hash; // Last frame
+        uint64_t run_hash; // Video and audio hashes of every frame
+        double milliseconds;
+        std::string error; // Empty if the job ran
+    };
+
+    // Throws std::runtime_error if the manifest can't be read or a line is malformed
+    Batch(const std::string &manifest_filename, std::shared_ptr<const nes::cart::RomDatabase> database = nullptr);
+
+    // Run every job, a job that fails records its error and the rest carry on
+    void run(utils::ThreadPool &pool);
+
+    const std::vector<Job> &jobs() const {
+        return m_jobs;
+    }
+    // In manifest order
+    const std::vector<Result> &results() const {
+        return m_results;
+    }
+    const size_t failures() const;
+
+    // A header then one row per job in manifest order
+    void write_csv(std::ostream &os) const;
+
+    static Result run_job(const Job &job, std::shared_ptr<const nes::cart::RomDatabase> database = nullptr);
+
+private:
+    std::vector<Job> m_jobs;
+    std::vector<Result> m_results;
+    std::shared_ptr<const nes::cart::RomDatabase> m_database;
+};
+
+} // nes
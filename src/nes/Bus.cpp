@@ -27,11 +27,17 @@ Emulation of the bus for the Nintendo Entertainment System that connects all of
 the components
 *******************************************************************************/
 
+#include <algorithm>
 #include <memory>
 #include <chrono>
 #include <thread>
+#include <vector>
+#include <stdexcept>
 
+#include <utils/string_format.hpp>
 #include <nes/Bus.hpp>
+#include <nes/ppu/PPU2C02Headless.hpp>
+#include <nes/apu/APURP2A03Headless.hpp>
 
 namespace nes {
 
@@ -51,31 +57,86 @@ void Bus::reset() {
     if (m_apu != nullptr) {
         m_apu->reset();
     }
+    if (m_controller != nullptr) {
+        m_controller->reset();
+    }
+
+    m_scheduler->reset();
+    m_oam_dma_page = 0x00;
+    m_oam_dma_end_cycle = 0;
+    if (m_apu != nullptr) {
+        schedule_dmc_dma();
+    }
+    reset_scanline_counter();
 
+    m_cpu_clock_phase = 0;
     m_clock_check_count = 0;
     m_clock_check_last_timestamp = std::chrono::high_resolution_clock::now();
 }
 
+void Bus::set_timing(const nes::Timing &timing) {
+    m_timing = &timing;
+    if (m_ppu != nullptr) {
+        m_ppu->set_timing(timing);
+    }
+    if (m_apu != nullptr) {
+        m_apu->set_timing(timing);
+    }
+
+    m_clock_check_after_count = nes::ppu::PPU2C02::SCREEN_WIDTH_INTERNAL * timing.scanlines;
+    m_clock_check_after_expected = 1000.0 / timing.frame_rate;
+}
+
 void Bus::clock() {
     Component::clock();
 
     // Clock the PPU
     m_ppu->clock();
 
-    // Clock the APU
-    m_apu->clock();
+    // 1/3 of PPU speed on NTSC and Dendy, 5/16 on PAL
+    m_cpu_clock_phase += m_timing->cpu_clocks;
+    if (m_cpu_clock_phase >= m_timing->ppu_clocks) {
+        m_cpu_clock_phase -= m_timing->ppu_clocks;
+        m_in_cpu_cycle = true;
+
+        // The APU runs at CPU speed
+        m_apu->clock();
+
+        // DMA transfers and anything else due this cycle
+        if (m_scheduler->pending()) {
+            run_scheduled_events();
+        }
+
+        // IRQs are only serviced between instructions
+        if (m_cpu->complete() && (m_apu->irq() || m_cart->irq())) {
+            m_cpu->irq();
+        }
 
-    // 1/3 of PPU and APU speeds
-    if (m_clock_count % 3 == 0) {
         // m_cpu->clock();
+
+        m_scheduler->tick();
+        m_in_cpu_cycle = false;
+    }
+
+    // Let the APU synthesize the rest of the frame in one go
+    if (m_ppu->frame_complete()) {
+        m_apu->end_frame();
+        m_cart->flush_battery_ram();
+
+        // Back to predicting the scanline counter
+        if (m_a12_exact) {
+            sync_scanline_counter();
+            m_a12_exact = false;
+            schedule_mapper_irq();
+        }
     }
 
     // Throttle clock speed
     m_clock_check_count++;
-    if (m_clock_check_count > CLOCK_CHECK_AFTER_COUNT) {
+    if (m_clock_check_count > m_clock_check_after_count) {
         auto clock_check_timestamp = std::chrono::high_resolution_clock::now();
         std::chrono::duration<double, std::milli> clock_check_diff = clock_check_timestamp - m_clock_check_last_timestamp;
-        std::chrono::duration<double, std::milli> clock_check_expected(CLOCK_CHECK_AFTER_EXPECTED);
+        std::chrono::duration<double, std::milli> clock_check_expected(m_clock_check_after_expected);
         std::chrono::duration<double, std::milli> clock_check_remaining = clock_check_expected - clock_check_diff;
 
         // TODO: Work in a sleep
@@ -89,9 +150,38 @@ void Bus::clock() {
 
 void Bus::load_cart(std::shared_ptr<nes::cart::Cart> cart) {
     m_cart = cart;
+    m_cart->connect_scheduler(m_scheduler);
+    switch (m_cart->timing_type()) {
+        case nes::cart::PAL: set_timing(nes::PAL_TIMING); break;
+        case nes::cart::DENDY: set_timing(nes::DENDY_TIMING); break;
+        default: set_timing(nes::NTSC_TIMING); break;
+    }
     reset();
 }
 
+std::shared_ptr<Bus> Bus::fork() {
+    // Copies the bus registers, then swaps in copies of the components
+    auto bus = std::make_shared<Bus>(*this);
+    bus->m_cpu = std::make_shared<nes::cpu::CPU2A03>(*m_cpu);
+    bus->m_ram = std::make_shared<nes::ram::Ram>(*m_ram);
+    bus->m_ppu = std::make_shared<nes::ppu::PPU2C02Headless>(*m_ppu);
+    bus->m_apu = std::make_shared<nes::apu::APURP2A03Headless>(*m_apu);
+    bus->m_controller = std::make_shared<nes::controller::Controller>(*m_controller);
+    bus->m_scheduler = std::make_shared<nes::Scheduler>(*m_scheduler);
+    if (m_cart != nullptr) {
+        bus->m_cart = m_cart->fork();
+        bus->m_cart->connect_scheduler(bus->m_scheduler);
+    }
+    bus->m_cpu->connect_bus(bus);
+    return bus;
+}
+
+void Bus::run_frame() {
+    do {
+        clock();
+    } while (!m_ppu->frame_complete());
+}
+
 const bool Bus::cpu_read(const uint16_t addr, uint8_t &data, const bool read_only) {
     data = 0x00;
 
@@ -99,11 +189,11 @@ const bool Bus::cpu_read(const uint16_t addr, uint8_t &data, const bool read_onl
     if (!m_cart->cpu_read(addr, data)) {
         if (addr >= ADDR_RAM_BEGIN && addr <= ADDR_RAM_END) {
             return m_ram->cpu_read(addr, data, read_only);
-        } else if (addr <= ADDR_PPU_BEGIN && addr <= ADDR_PPU_END) {
+        } else if (addr >= ADDR_PPU_BEGIN && addr <= ADDR_PPU_END) {
             return m_ppu->cpu_read(addr, data, read_only);
         } else if (addr == ADDR_APU_STATUS) {
             return m_apu->cpu_read(addr, data, read_only);
-        } else if (addr <= ADDR_CONTROLLER_BEGIN && addr <= ADDR_CONTROLLER_END) {
+        } else if (addr >= ADDR_CONTROLLER_BEGIN && addr <= ADDR_CONTROLLER_END) {
             return m_controller->cpu_read(addr, data, read_only);
         }
     } else {
@@ -114,15 +204,47 @@ const bool Bus::cpu_read(const uint16_t addr, uint8_t &data, const bool read_onl
 }
 
 const bool Bus::cpu_write(const uint16_t addr, const uint8_t data) {
+    // Bring the scanline counter up to date before the mapper registers change
+    if (m_scanline_counter && addr >= ADDR_CART_BEGIN) {
+        sync_scanline_counter();
+        const bool handled = m_cart->cpu_write(addr, data);
+        schedule_mapper_irq();
+        return handled;
+    }
+
     // Give the cartridge / mapper the chance to handle the write
     if (!m_cart->cpu_write(addr, data)) {
         if (addr >= ADDR_RAM_BEGIN && addr <= ADDR_RAM_END) {
             return m_ram->cpu_write(addr, data);
-        } else if (addr <= ADDR_PPU_BEGIN && addr <= ADDR_PPU_END) {
-            return m_ppu->cpu_write(addr, data);
-        } else if ((addr <= ADDR_APU_BEGIN && addr <= ADDR_APU_END) || addr == ADDR_APU_STATUS || addr == ADDR_APU_FRAME_COUNTER) {
-            return m_apu->cpu_write(addr, data);
-        } else if (addr <= ADDR_CONTROLLER_BEGIN && addr <= ADDR_CONTROLLER_END) {
+        } else if (addr >= ADDR_PPU_BEGIN && addr <= ADDR_PPU_END) {
+            if (!m_scanline_counter) {
+                return m_ppu->cpu_write(addr, data);
+            }
+
+            // PPUCTRL and PPUMASK decide where A12 rises, count up to here
+            // with the old setup
+            sync_scanline_counter();
+            const bool handled = m_ppu->cpu_write(addr, data);
+            const int16_t a12_rise_dot = m_ppu->a12_rise_dot();
+            if (a12_rise_dot != m_a12_rise_dot) {
+                m_a12_rise_dot = a12_rise_dot;
+                if (m_ppu->frame_dot() < nes::ppu::PPU2C02::SCREEN_HEIGHT * nes::ppu::PPU2C02::SCREEN_WIDTH_INTERNAL) {
+                    m_a12_exact = true;
+                }
+                schedule_mapper_irq();
+            }
+            return handled;
+        } else if ((addr >= ADDR_APU_BEGIN && addr <= ADDR_APU_END) || addr == ADDR_APU_STATUS || addr == ADDR_APU_FRAME_COUNTER) {
+            const bool handled = m_apu->cpu_write(addr, data);
+            // The write may have changed when the next sample byte is needed
+            schedule_dmc_dma();
+            return handled;
+        } else if (addr == ADDR_DMA) {
+            // The transfer starts once the CPU is done with the bus
+            m_oam_dma_page = data;
+            m_scheduler->schedule(nes::Scheduler::OAM_DMA, m_scheduler->now());
+            return true;
+        } else if (addr >= ADDR_CONTROLLER_BEGIN && addr <= ADDR_CONTROLLER_END) {
             return m_controller->cpu_write(addr, data);
         }
     } else {
@@ -132,4 +254,245 @@ const bool Bus::cpu_write(const uint16_t addr, const uint8_t data) {
     return false;
 }
 
+void Bus::run_scheduled_events() {
+    nes::Scheduler::Event event;
+    while (m_scheduler->pop(event)) {
+        switch (event) {
+            case nes::Scheduler::OAM_DMA: run_oam_dma(); break;
+            case nes::Scheduler::DMC_DMA: run_dmc_dma(); break;
+            case nes::Scheduler::MAPPER_IRQ: sync_scanline_counter(); schedule_mapper_irq(); break;
+            default: break;
+        }
+    }
+}
+
+/**
+ * Copy a page of CPU memory into PPU OAM.  Takes 513 cycles, plus one more
+ * to line up with a read cycle when it starts on an odd cycle.
+ */
+void Bus::run_oam_dma() {
+    const uint16_t page_addr = (uint16_t)m_oam_dma_page << 8;
+    const uint8_t *page = oam_dma_page(page_addr);
+    if (page != nullptr) {
+        m_ppu->oam_dma(page);
+    } else {
+        // Registers or unmapped memory, go through the bus byte by byte
+        for (uint16_t i = 0; i < OAM_DMA_SIZE; i++) {
+            uint8_t data = 0x00;
+            cpu_read(page_addr | i, data);
+            m_ppu->oam_dma_write(data);
+        }
+    }
+
+    const uint16_t cycles = OAM_DMA_CYCLES + (m_scheduler->now() & 1);
+    m_cpu->stall(cycles);
+    m_oam_dma_end_cycle = m_scheduler->now() + cycles;
+}
+
+/**
+ * Memory backing a whole source page for OAM DMA, or nullptr when the page
+ * has to be read through the bus
+ */
+const uint8_t *Bus::oam_dma_page(const uint16_t page_addr) {
+    // Same priority as cpu_read, the cartridge gets first pick
+    const uint8_t *page = m_cart != nullptr ? m_cart->cpu_page(page_addr) : nullptr;
+    if (page == nullptr && page_addr <= ADDR_RAM_END) {
+        page = m_ram->page(page_addr);
+    }
+    return page;
+}
+
+/**
+ * Fetch the next DMC sample byte on the cycle the APU predicted it would be
+ * needed.  Steals 4 cycles, or 2 when it lands in the middle of OAM DMA.
+ */
+void Bus::run_dmc_dma() {
+    uint8_t data = 0x00;
+    cpu_read(m_apu->dmc_fetch_addr(), data);
+    m_apu->dmc_dma(data);
+
+    m_cpu->stall(m_scheduler->now() < m_oam_dma_end_cycle ? DMC_DMA_CYCLES_DURING_OAM_DMA : DMC_DMA_CYCLES);
+
+    schedule_dmc_dma();
+}
+
+void Bus::schedule_dmc_dma() {
+    const uint64_t cycles = m_apu->cycles_until_dmc_fetch();
+    if (cycles == nes::apu::APURP2A03::NEVER) {
+        m_scheduler->cancel(nes::Scheduler::DMC_DMA);
+    } else {
+        m_scheduler->schedule(nes::Scheduler::DMC_DMA, m_scheduler->now() + cycles);
+    }
+}
+
+void Bus::save_state(std::vector<uint8_t> &buffer) const {
+    StateWriter state(buffer);
+    state.begin("NES ");
+    state.write(StateWriter::VERSION);
+    state.write(m_cart->crc32());
+    save_state(state);
+}
+
+void Bus::load_state(const std::vector<uint8_t> &buffer) {
+    StateReader state(buffer.data(), buffer.size());
+    state.begin("NES ");
+    uint32_t version;
+    state.read(version);
+    if (version != StateWriter::VERSION) {
+        throw std::runtime_error(utils::string_format("Save state version %u isn't supported, expected %u", version, StateWriter::VERSION));
+    }
+    uint32_t crc32;
+    state.read(crc32);
+    if (crc32 != m_cart->crc32()) {
+        throw std::runtime_error(utils::string_format("Save state is for ROM %08X but %08X is loaded", crc32, m_cart->crc32()));
+    }
+    load_state(state);
+}
+
+void Bus::save_state(StateWriter &state) const {
+    state.begin("BUS ");
+    Component::save_state(state);
+    state.write(m_cpu_clock_phase);
+    state.write(m_oam_dma_page);
+    state.write(m_oam_dma_end_cycle);
+    state.write(m_a12_rise_dot);
+    state.write(m_a12_exact);
+    state.write(m_a12_sync_clock);
+    state.write(m_a12_sync_dot);
+    m_scheduler->save_state(state);
+
+    m_cpu->save_state(state);
+    m_ram->save_state(state);
+    m_ppu->save_state(state);
+    m_apu->save_state(state);
+    m_controller->save_state(state);
+    m_cart->save_state(state);
+}
+
+void Bus::load_state(StateReader &state) {
+    state.begin("BUS ");
+    Component::load_state(state);
+    state.read(m_cpu_clock_phase);
+    state.read(m_oam_dma_page);
+    state.read(m_oam_dma_end_cycle);
+    state.read(m_a12_rise_dot);
+    state.read(m_a12_exact);
+    state.read(m_a12_sync_clock);
+    state.read(m_a12_sync_dot);
+    m_scheduler->load_state(state);
+
+    m_cpu->load_state(state);
+    m_ram->load_state(state);
+    m_ppu->load_state(state);
+    m_apu->load_state(state);
+    m_controller->load_state(state);
+    m_cart->load_state(state);
+}
+
+void Bus::reset_scanline_counter() {
+    m_scanline_counter = m_cart != nullptr && m_cart->scanline_counter();
+    m_a12_rise_dot = m_ppu->a12_rise_dot();
+    m_a12_exact = false;
+    m_a12_sync_clock = m_clock_count;
+    m_a12_sync_dot = m_ppu->frame_dot();
+    schedule_mapper_irq();
+}
+
+/**
+ * Number of A12 rises on dots before frame_dot in a frame
+ */
+const uint32_t Bus::a12_rises_before(const uint32_t frame_dot) const {
+    if (m_a12_rise_dot == nes::ppu::PPU2C02::NO_A12_RISE || frame_dot <= (uint32_t)m_a12_rise_dot) {
+        return 0;
+    }
+
+    const uint32_t width = nes::ppu::PPU2C02::SCREEN_WIDTH_INTERNAL;
+    const uint32_t visible = std::min<uint32_t>((frame_dot - m_a12_rise_dot - 1) / width + 1, nes::ppu::PPU2C02::SCREEN_HEIGHT);
+    const uint32_t pre_render = frame_dot > (m_ppu->scanlines() - 1) * width + m_a12_rise_dot ? 1 : 0;
+    return visible + pre_render;
+}
+
+/**
+ * Number of A12 rises on the dots dots starting at frame_dot
+ */
+const uint64_t Bus::a12_rises(const uint32_t frame_dot, const uint64_t dots) const {
+    const uint32_t frame_dots = m_ppu->frame_dots();
+    const uint64_t per_frame = a12_rises_before(frame_dots);
+    const uint32_t end = frame_dot + (uint32_t)(dots % frame_dots);
+
+    uint64_t rises = (dots / frame_dots) * per_frame;
+    if (end <= frame_dots) {
+        rises += a12_rises_before(end) - a12_rises_before(frame_dot);
+    } else {
+        rises += per_frame - a12_rises_before(frame_dot) + a12_rises_before(end - frame_dots);
+    }
+    return rises;
+}
+
+/**
+ * Dots from the next one to be drawn up to and including the count'th A12 rise,
+ * Scheduler::NEVER if A12 doesn't rise
+ */
+const uint64_t Bus::dots_until_a12_rise(const uint32_t count) const {
+    const uint32_t frame_dots = m_ppu->frame_dots();
+    const uint32_t per_frame = a12_rises_before(frame_dots);
+    if (per_frame == 0 || count == 0) {
+        return nes::Scheduler::NEVER;
+    }
+
+    const uint32_t width = nes::ppu::PPU2C02::SCREEN_WIDTH_INTERNAL;
+    auto rise_dot = [&](const uint32_t index) -> uint32_t {
+        const uint32_t scanline = index < nes::ppu::PPU2C02::SCREEN_HEIGHT ? index : m_ppu->scanlines() - 1;
+        return scanline * width + m_a12_rise_dot;
+    };
+
+    const uint32_t frame_dot = m_ppu->frame_dot();
+    const uint64_t frames = (count - 1) / per_frame;
+    const uint32_t remaining = count - (uint32_t)frames * per_frame;
+    const uint32_t passed = a12_rises_before(frame_dot);
+
+    uint64_t dots = frames * frame_dots;
+    if (passed + remaining <= per_frame) {
+        dots += rise_dot(passed + remaining - 1) - frame_dot;
+    } else {
+        dots += frame_dots - frame_dot + rise_dot(passed + remaining - per_frame - 1);
+    }
+    return dots + 1;
+}
+
+void Bus::sync_scanline_counter() {
+    if (!m_scanline_counter) {
+        return;
+    }
+
+    const uint64_t rises = a12_rises(m_a12_sync_dot, m_clock_count - m_a12_sync_clock);
+    if (rises > 0) {
+        m_cart->clock_scanline_counter((uint32_t)std::min<uint64_t>(rises, UINT32_MAX));
+    }
+    m_a12_sync_clock = m_clock_count;
+    m_a12_sync_dot = m_ppu->frame_dot();
+}
+
+/**
+ * Schedule the CPU cycle the mapper IRQ will assert on, or the next scanline
+ * when tracking exactly
+ */
+void Bus::schedule_mapper_irq() {
+    if (!m_scanline_counter) {
+        return;
+    }
+
+    const uint32_t clocks = m_a12_exact ? 1 : m_cart->scanline_clocks_until_irq();
+    const uint64_t dots = clocks != nes::cart::mapper::Mapper::NO_SCANLINE_IRQ ? dots_until_a12_rise(clocks) : nes::Scheduler::NEVER;
+    if (dots == nes::Scheduler::NEVER) {
+        m_scheduler->cancel(nes::Scheduler::MAPPER_IRQ);
+        return;
+    }
+
+    // First CPU cycle that runs at or after the dot with the rise, now() is
+    // already taken while inside a CPU cycle
+    const uint64_t cpu_cycles = (m_cpu_clock_phase + (dots - 1) * m_timing->cpu_clocks) / m_timing->ppu_clocks;
+    m_scheduler->schedule(nes::Scheduler::MAPPER_IRQ, m_scheduler->now() + cpu_cycles + (m_in_cpu_cycle ? 1 : 0));
+}
+
 } // nes
\ No newline at end of file
@@ -31,9 +31,12 @@ the components
 
 #include <cstdint>
 #include <memory>
+#include <vector>
 #include <chrono>
 
 #include <nes/Component.hpp>
+#include <nes/Scheduler.hpp>
+#include <nes/Timing.hpp>
 #include <nes/cpu/CPU2A03.hpp>
 #include <nes/ram/Ram.hpp>
 #include <nes/ppu/PPU2C02.hpp>
@@ -56,18 +59,48 @@ public:
         , m_ram(ram)
         , m_ppu(ppu)
         , m_apu(apu)
-        , m_controller(controller) {
+        , m_controller(controller)
+        , m_scheduler(std::make_shared<nes::Scheduler>()) {
+        set_timing(nes::NTSC_TIMING);
     }
 
     void reset() override;
 
     void clock() override;
 
+    // Clock until the PPU finishes the current frame
+    void run_frame();
+
+    // Turn drawing and sound off for frames nobody will see or hear
+    void set_output_enabled(const bool video, const bool audio) {
+        m_ppu->set_output_enabled(video);
+        m_apu->set_output_enabled(audio);
+    }
+
+    // Also switches to the cart's console region
     void load_cart(std::shared_ptr<nes::cart::Cart> cart);
 
+    // CPU/PPU clock ratio, scanlines and frame rate of the console region
+    void set_timing(const nes::Timing &timing);
+
     const bool cpu_read(const uint16_t addr, uint8_t &data, const bool read_only = false) override;
     const bool cpu_write(const uint16_t addr, const uint8_t data) override;
 
+    // Snapshot of the whole machine between clocks.  Reusing the buffer from
+    // the last save avoids allocating.
+    void save_state(std::vector<uint8_t> &buffer) const;
+    // Throws std::runtime_error if the state is from another version or ROM
+    void load_state(const std::vector<uint8_t> &buffer);
+
+    void save_state(StateWriter &state) const override;
+    void load_state(StateReader &state) override;
+
+    // Second machine carrying on from exactly this point, for tree search.  ROM
+    // stays shared, RAM, OAM and cart RAM are shared until either machine
+    // writes to them and the registers are copied.  The child draws and plays
+    // into headless outputs.
+    std::shared_ptr<Bus> fork();
+
 private:
     static const uint16_t ADDR_RAM_BEGIN = 0x0000; static const uint16_t ADDR_RAM_END = 0x1FFF;
     static const uint16_t ADDR_PPU_BEGIN = 0x2000; static const uint16_t ADDR_PPU_END = 0x3FFF;
@@ -75,6 +108,7 @@ private:
     static const uint16_t ADDR_APU_STATUS = 0x4015; static const uint16_t ADDR_APU_FRAME_COUNTER = 0x4017;
     static const uint16_t ADDR_DMA = 0x4014;
     static const uint16_t ADDR_CONTROLLER_BEGIN = 0x4016; static const uint16_t ADDR_CONTROLLER_END = 0x4017;
+    static const uint16_t ADDR_CART_BEGIN = 0x4020;
 
     std::shared_ptr<nes::cpu::CPU2A03> m_cpu;
     std::shared_ptr<nes::ram::Ram> m_ram;
@@ -82,10 +116,46 @@ private:
     std::shared_ptr<nes::apu::APURP2A03> m_apu;
     std::shared_ptr<nes::controller::Controller> m_controller;
     std::shared_ptr<nes::cart::Cart> m_cart;
-
-    static constexpr uint32_t CLOCK_CHECK_AFTER_COUNT = 341 * 262; // Check roughly every screen render
-    static constexpr double CLOCK_CHECK_AFTER_EXPECTED = ((1.0 / 60.0) * 1000.0); // Roughly 60 fps or 21441960Hz
-
+    std::shared_ptr<nes::Scheduler> m_scheduler;
+
+    static const uint16_t OAM_DMA_SIZE = 256;
+    static const uint16_t OAM_DMA_CYCLES = 513; // Plus one when starting on an odd cycle
+    static const uint16_t DMC_DMA_CYCLES = 4;
+    static const uint16_t DMC_DMA_CYCLES_DURING_OAM_DMA = 2;
+
+    uint8_t m_oam_dma_page;
+    uint64_t m_oam_dma_end_cycle;
+
+    void run_scheduled_events();
+    void run_oam_dma();
+    const uint8_t *oam_dma_page(const uint16_t page_addr);
+    void run_dmc_dma();
+    void schedule_dmc_dma();
+
+    // Mapper scanline counters (MMC3) are clocked by PPU A12 rising once per
+    // rendering scanline.  Rather than watching the PPU, the bus counts the
+    // rises since the last sync from the frame layout and schedules the IRQ.
+    // After PPUCTRL/PPUMASK change mid-frame it steps one scanline per event
+    // until the frame ends.
+    bool m_scanline_counter;
+    int16_t m_a12_rise_dot;
+    bool m_a12_exact;
+    uint64_t m_a12_sync_clock;
+    uint32_t m_a12_sync_dot;
+    bool m_in_cpu_cycle = false;
+
+    const uint32_t a12_rises_before(const uint32_t frame_dot) const;
+    const uint64_t a12_rises(const uint32_t frame_dot, const uint64_t dots) const;
+    const uint64_t dots_until_a12_rise(const uint32_t count) const;
+    void sync_scanline_counter();
+    void schedule_mapper_irq();
+    void reset_scanline_counter();
+
+    const nes::Timing *m_timing = &nes::NTSC_TIMING;
+    uint32_t m_cpu_clock_phase; // PPU dots towards the next CPU cycle, scaled by cpu_clocks
+
+    uint32_t m_clock_check_after_count; // Check roughly every screen render
+    double m_clock_check_after_expected; // Milliseconds per frame
     uint32_t m_clock_check_count;
     std::chrono::time_point<std::chrono::high_resolution_clock> m_clock_check_last_timestamp;
 };
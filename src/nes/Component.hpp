@@ -28,6 +28,10 @@ Shared component interface
 
 #pragma once
 
+#include <cstdint>
+
+#include <nes/State.hpp>
+
 namespace nes {
 
 class Component {
@@ -41,8 +45,16 @@ public:
     virtual const bool cpu_read(const uint16_t addr, uint8_t &data, const bool read_only = false) = 0;
     virtual const bool cpu_write(const uint16_t addr, const uint8_t data) = 0;
 
+    // Save states, overrides call these first and then handle their own fields
+    virtual void save_state(StateWriter &state) const {
+        state.write(m_clock_count);
+    }
+    virtual void load_state(StateReader &state) {
+        state.read(m_clock_count);
+    }
+
 protected:
-    uint32_t m_clock_count = 0;
+    uint64_t m_clock_count = 0;
 
 };
 
@@ -0,0 +1,107 @@
+/*******************************************************************************
+MIT License
+
+Copyright (c) 2020 Chris Luby
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+/*******************************************************************************
+Memory that forked machines share until one of them writes to it.  Copying a
+buffer only copies a reference, and whichever side writes first while the
+memory is still shared takes its own copy.  Reads always go straight to the
+memory, writers keep the pointer from writable_data() until the next fork.
+*******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace nes {
+
+class CowBuffer {
+public:
+    CowBuffer() {
+    }
+    CowBuffer(const size_t size, const uint8_t value = 0x00) {
+        assign(size, value);
+    }
+
+    // The copy shares the memory, so both sides lose their write access
+    CowBuffer(const CowBuffer &other)
+        : m_memory(other.m_memory)
+        , m_data(other.m_data) {
+        other.m_writable = nullptr;
+    }
+    CowBuffer &operator=(const CowBuffer &other) {
+        if (this != &other) {
+            m_memory = other.m_memory;
+            m_data = other.m_data;
+            m_writable = nullptr;
+            other.m_writable = nullptr;
+        }
+        return *this;
+    }
+
+    // Fresh memory of its own
+    void assign(const size_t size, const uint8_t value = 0x00) {
+        m_memory = std::make_shared<std::vector<uint8_t>>(size, value);
+        m_data = m_writable = m_memory->data();
+    }
+    void assign(const uint8_t *data, const size_t size) {
+        m_memory = std::make_shared<std::vector<uint8_t>>(data, data + size);
+        m_data = m_writable = m_memory->data();
+    }
+
+    const size_t size() const {
+        return m_memory != nullptr ? m_memory->size() : 0;
+    }
+
+    // Moves if writable_data() has to copy
+    const uint8_t *data() const {
+        return m_data;
+    }
+
+    // Another machine may still be reading the memory
+    const bool shared() const {
+        return m_writable == nullptr && m_memory != nullptr && m_memory.use_count() > 1;
+    }
+
+    uint8_t *writable_data() {
+        if (m_writable == nullptr && m_memory != nullptr) {
+            // A count of one can't go up again behind our back, only a copy of
+            // this buffer can share it
+            if (m_memory.use_count() > 1) {
+                m_memory = std::make_shared<std::vector<uint8_t>>(*m_memory);
+            }
+            m_data = m_writable = m_memory->data();
+        }
+        return m_writable;
+    }
+
+private:
+    std::shared_ptr<std::vector<uint8_t>> m_memory;
+    const uint8_t *m_data = nullptr;
+    mutable uint8_t *m_writable = nullptr;
+};
+
+} // nes
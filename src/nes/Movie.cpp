@@ -0,0 +1,92 @@
+/*******************************************************************************
+MIT License
+
+Copyright (c) 2020 Chris Luby
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+/*******************************************************************************
+Input movies in FCEUX's text FM2 format
+*******************************************************************************/
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <stdexcept>
+
+#include <utils/string_format.hpp>
+#include <nes/Movie.hpp>
+
+namespace nes {
+
+Movie::Movie(const std::string &filename) {
+    std::ifstream file(filename);
+    if (!file) {
+        throw std::runtime_error(utils::string_format("Unable to open movie %s", filename.c_str()));
+    }
+
+    std::string line;
+    while (std::getline(file, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty()) {
+            continue;
+        }
+        if (line[0] != '|') {
+            if (line == "binary 1") {
+                throw std::runtime_error(utils::string_format("Movie %s is a binary FM2, only text ones are supported", filename.c_str()));
+            }
+            continue;
+        }
+
+        // |commands|port 0|port 1|port 2|
+        std::vector<std::string> fields;
+        size_t start = 1;
+        size_t end;
+        while ((end = line.find('|', start)) != std::string::npos) {
+            fields.push_back(line.substr(start, end - start));
+            start = end + 1;
+        }
+
+        Frame frame = {};
+        if (fields.size() > 0 && !fields[0].empty()) {
+            frame.commands = (uint8_t)std::stoul(fields[0]);
+        }
+        for (uint8_t port = 0; port < NUM_PORTS && port + 1 < (uint8_t)fields.size(); port++) {
+            frame.buttons[port] = parse_buttons(fields[port + 1]);
+        }
+        m_frames.push_back(frame);
+    }
+}
+
+const uint8_t Movie::parse_buttons(const std::string &field) {
+    // RLDUTSBA, the leftmost is the highest bit of the controller's button byte
+    uint8_t buttons = 0x00;
+    for (size_t i = 0; i < field.size() && i < 8; i++) {
+        if (field[i] != '.' && field[i] != ' ') {
+            buttons |= 0x80 >> i;
+        }
+    }
+    return buttons;
+}
+
+} // nes
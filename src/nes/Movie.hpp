@@ -0,0 +1,79 @@
+/*******************************************************************************
+MIT License
+
+Copyright (c) 2020 Chris Luby
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+/*******************************************************************************
+Input movies in FCEUX's text FM2 format, the one most NES recordings and TASes
+are shared in.  Header lines are "key value", then every frame is a line like
+  |0|RLDUTSBA|........||
+holding the reset commands and a button string per port, where anything but
+'.' or ' ' is a held button.
+
+Links:
+- https://fceux.com/web/help/fm2.html
+*******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace nes {
+
+class Movie {
+public:
+    static const uint8_t NUM_PORTS = 2;
+
+    // Throws std::runtime_error if the file can't be read or is a binary FM2
+    Movie(const std::string &filename);
+
+    const uint32_t frames() const {
+        return (uint32_t)m_frames.size();
+    }
+
+    // Controller buttons for the frame, none held past the end
+    const uint8_t buttons(const uint32_t frame, const uint8_t port) const {
+        return frame < m_frames.size() && port < NUM_PORTS ? m_frames[frame].buttons[port] : 0x00;
+    }
+
+    // The console is reset (soft or power) before the frame
+    const bool reset(const uint32_t frame) const {
+        return frame < m_frames.size() && (m_frames[frame].commands & (COMMAND_SOFT_RESET | COMMAND_HARD_RESET)) != 0;
+    }
+
+private:
+    static const uint8_t COMMAND_SOFT_RESET = 0x01;
+    static const uint8_t COMMAND_HARD_RESET = 0x02;
+
+    struct Frame {
+        uint8_t commands;
+        uint8_t buttons[NUM_PORTS];
+    };
+
+    std::vector<Frame> m_frames;
+
+    static const uint8_t parse_buttons(const std::string &field);
+};
+
+} // nes
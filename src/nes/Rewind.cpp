@@ -0,0 +1,214 @@
+/*******************************************************************************
+MIT License
+
+Copyright (c) 2020 Chris Luby
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+/*******************************************************************************
+Rewind history kept within a fixed memory budget.  Every frame's save state is
+stored as the XOR against the previous frame, which is almost all zeros, with
+runs of zeros squeezed out.  Every keyframe_interval frames a whole state is
+stored instead so stepping back only walks the deltas since the last keyframe,
+and the oldest keyframe with its deltas is dropped when the budget runs out.
+*******************************************************************************/
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+#include <deque>
+
+#include <nes/Rewind.hpp>
+
+namespace nes {
+
+Rewind::Rewind(const size_t budget, const uint32_t keyframe_interval)
+    : m_ring(budget)
+    , m_keyframe_interval(keyframe_interval > 0 ? keyframe_interval : 1) {
+    clear();
+}
+
+void Rewind::clear() {
+    m_head = 0;
+    m_entries.clear();
+    m_frames_since_keyframe = 0;
+    m_last.clear();
+}
+
+const size_t Rewind::used() const {
+    size_t used = 0;
+    for (const auto &entry : m_entries) {
+        used += entry.size;
+    }
+    return used;
+}
+
+void Rewind::push(const std::vector<uint8_t> &state) {
+    // A keyframe is needed to start a chain, and when the layout changed
+    bool keyframe = m_entries.empty() || m_frames_since_keyframe + 1 >= m_keyframe_interval || state.size() != m_last.size();
+    if (keyframe) {
+        encode(state.data(), state.size(), m_scratch);
+    } else {
+        // XOR in place, m_last becomes the new state again after encoding
+        for (size_t i = 0; i < state.size(); i++) {
+            m_last[i] ^= state[i];
+        }
+        encode(m_last.data(), m_last.size(), m_scratch);
+    }
+    m_last = state;
+
+    // Making room may have dropped the frame the delta is against
+    if (!store(keyframe) && !keyframe) {
+        encode(state.data(), state.size(), m_scratch);
+        store(true);
+    }
+}
+
+/**
+ * Copy m_scratch into the ring, dropping the oldest frames to make room.  False
+ * if a delta lost its base frame in the process (or the frame doesn't fit).
+ */
+const bool Rewind::store(const bool keyframe) {
+    const size_t size = m_scratch.size();
+    if (size > m_ring.size()) {
+        clear();
+        return false;
+    }
+
+    size_t start = m_head;
+    if (start + size > m_ring.size()) {
+        // Everything from the head to the end of the ring is older than the rest
+        while (!m_entries.empty() && m_entries.front().offset >= m_head) {
+            evict_oldest();
+        }
+        start = 0;
+    }
+    while (!m_entries.empty() && m_entries.front().offset >= start && m_entries.front().offset < start + size) {
+        evict_oldest();
+    }
+    if (!keyframe && m_entries.empty()) {
+        return false;
+    }
+
+    memcpy(m_ring.data() + start, m_scratch.data(), size);
+    m_entries.push_back({ start, size, keyframe });
+    m_head = start + size;
+    m_frames_since_keyframe = keyframe ? 0 : m_frames_since_keyframe + 1;
+    return true;
+}
+
+/**
+ * Deltas are useless without their keyframe, so they go together
+ */
+void Rewind::evict_oldest() {
+    m_entries.pop_front();
+    while (!m_entries.empty() && !m_entries.front().keyframe) {
+        m_entries.pop_front();
+    }
+}
+
+const bool Rewind::step_back(std::vector<uint8_t> &state) {
+    if (m_entries.size() < 2) {
+        return false;
+    }
+    m_entries.pop_back();
+    m_head = m_entries.back().offset + m_entries.back().size;
+
+    // Rebuild from the last keyframe
+    size_t keyframe = m_entries.size() - 1;
+    while (!m_entries[keyframe].keyframe) {
+        keyframe--;
+    }
+    m_last.clear();
+    for (size_t i = keyframe; i < m_entries.size(); i++) {
+        decode_xor(m_ring.data() + m_entries[i].offset, m_entries[i].size, m_last);
+    }
+    m_frames_since_keyframe = (uint32_t)(m_entries.size() - 1 - keyframe);
+
+    state = m_last;
+    return true;
+}
+
+void Rewind::encode(const uint8_t *data, const size_t size, std::vector<uint8_t> &out) {
+    out.clear();
+    size_t i = 0;
+    while (i < size) {
+        const size_t zeros_begin = i;
+        while (i < size && data[i] == 0x00) {
+            i++;
+        }
+        // Short zero runs cost more to break out than to keep as literals
+        const size_t literals_begin = i;
+        while (i < size && (data[i] != 0x00 || (i + 2 < size && data[i + 1] != 0x00 && data[i + 2] != 0x00))) {
+            i++;
+        }
+        write_varint(out, literals_begin - zeros_begin);
+        write_varint(out, i - literals_begin);
+        out.insert(out.end(), data + literals_begin, data + i);
+    }
+}
+
+/**
+ * XOR an encoded frame into state, an empty state takes the frame as is
+ */
+void Rewind::decode_xor(const uint8_t *data, const size_t size, std::vector<uint8_t> &state) {
+    const bool fresh = state.empty();
+    const uint8_t *end = data + size;
+    size_t offset = 0;
+    while (data < end) {
+        offset += read_varint(data);
+        const size_t literals = read_varint(data);
+        if (fresh) {
+            state.resize(offset + literals, 0x00);
+            memcpy(state.data() + offset, data, literals);
+        } else {
+            for (size_t i = 0; i < literals; i++) {
+                state[offset + i] ^= data[i];
+            }
+        }
+        data += literals;
+        offset += literals;
+    }
+    if (fresh) {
+        state.resize(offset, 0x00);
+    }
+}
+
+void Rewind::write_varint(std::vector<uint8_t> &out, size_t value) {
+    while (value >= 0x80) {
+        out.push_back((uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((uint8_t)value);
+}
+
+const size_t Rewind::read_varint(const uint8_t *&data) {
+    size_t value = 0;
+    uint8_t shift = 0;
+    while (*data & 0x80) {
+        value |= (size_t)(*data++ & 0x7F) << shift;
+        shift += 7;
+    }
+    value |= (size_t)*data++ << shift;
+    return value;
+}
+
+} // nes
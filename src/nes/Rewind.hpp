@@ -0,0 +1,92 @@
+/*******************************************************************************
+MIT License
+
+Copyright (c) 2020 Chris Luby
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+/*******************************************************************************
+Rewind history kept within a fixed memory budget.  Every frame's save state is
+stored as the XOR against the previous frame, which is almost all zeros, with
+runs of zeros squeezed out.  Every keyframe_interval frames a whole state is
+stored instead so stepping back only walks the deltas since the last keyframe,
+and the oldest keyframe with its deltas is dropped when the budget runs out.
+
+Encoding of a stored frame, repeated until the end of the state:
+  varint zero run, varint literal count, literal bytes
+*******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <deque>
+
+namespace nes {
+
+class Rewind {
+public:
+    Rewind(const size_t budget, const uint32_t keyframe_interval = 60);
+
+    // Add the state for the frame just finished
+    void push(const std::vector<uint8_t> &state);
+
+    // Drop the newest frame and hand back the one before it, false if there
+    // is no earlier frame
+    const bool step_back(std::vector<uint8_t> &state);
+
+    void clear();
+
+    // Frames that can be stepped back through
+    const size_t frames() const {
+        return m_entries.size();
+    }
+
+    // Bytes of the budget in use
+    const size_t used() const;
+
+private:
+    struct Entry {
+        size_t offset;
+        size_t size;
+        bool keyframe;
+    };
+
+    std::vector<uint8_t> m_ring;
+    size_t m_head;
+    std::deque<Entry> m_entries;
+    uint32_t m_keyframe_interval;
+    uint32_t m_frames_since_keyframe;
+
+    // Newest frame in full, what the next delta is taken against
+    std::vector<uint8_t> m_last;
+    std::vector<uint8_t> m_scratch;
+
+    const bool store(const bool keyframe);
+    void evict_oldest();
+
+    static void encode(const uint8_t *data, const size_t size, std::vector<uint8_t> &out);
+    static void decode_xor(const uint8_t *data, const size_t size, std::vector<uint8_t> &state);
+    static void write_varint(std::vector<uint8_t> &out, size_t value);
+    static const size_t read_varint(const uint8_t *&data);
+};
+
+} // nes
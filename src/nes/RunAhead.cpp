@@ -0,0 +1,64 @@
+/*******************************************************************************
+MIT License
+
+Copyright (c) 2020 Chris Luby
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+/*******************************************************************************
+Run-ahead hides the frames of input lag games build in.  Each host frame the
+real frame is emulated with the current input, then the machine is saved, run
+the given number of frames further with the same input, the last one shown and
+the save loaded again.  Only the real frame is heard and only the last
+speculative frame is drawn, so the extra frames cost emulation and nothing else.
+*******************************************************************************/
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <nes/RunAhead.hpp>
+
+namespace nes {
+
+void RunAhead::run_frame() {
+    if (m_frames == 0) {
+        m_bus->run_frame();
+        return;
+    }
+
+    // The real frame
+    m_bus->set_output_enabled(false, true);
+    m_bus->run_frame();
+    m_bus->save_state(m_state);
+
+    // Frames the player is ahead of
+    m_bus->set_output_enabled(false, false);
+    for (uint32_t frame = 1; frame < m_frames; frame++) {
+        m_bus->run_frame();
+    }
+    m_bus->set_output_enabled(true, false);
+    m_bus->run_frame();
+
+    m_bus->load_state(m_state);
+    m_bus->set_output_enabled(true, true);
+}
+
+} // nes
@@ -0,0 +1,95 @@
+/*******************************************************************************
+MIT License
+
+Copyright (c) 2020 Chris Luby
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+/*******************************************************************************
+Schedules bus events (DMA transfers, predicted IRQs) for a specific CPU cycle so
+nothing has to be polled every cycle
+*******************************************************************************/
+
+#include <cstdint>
+
+#include <nes/Scheduler.hpp>
+
+namespace nes {
+
+void Scheduler::reset() {
+    m_cycle = 0;
+    for (auto &cycle : m_cycles) {
+        cycle = NEVER;
+    }
+    m_next_cycle = NEVER;
+}
+
+void Scheduler::schedule(const Event event, const uint64_t cycle) {
+    m_cycles[event] = cycle;
+    update_next();
+}
+
+void Scheduler::cancel(const Event event) {
+    m_cycles[event] = NEVER;
+    update_next();
+}
+
+const bool Scheduler::pop(Event &event) {
+    if (!pending()) {
+        return false;
+    }
+
+    // Ties go to the lowest event number
+    uint32_t earliest = 0;
+    for (uint32_t i = 1; i < NUM_EVENTS; i++) {
+        if (m_cycles[i] < m_cycles[earliest]) {
+            earliest = i;
+        }
+    }
+
+    event = (Event)earliest;
+    m_cycles[earliest] = NEVER;
+    update_next();
+    return true;
+}
+
+void Scheduler::update_next() {
+    m_next_cycle = NEVER;
+    for (auto cycle : m_cycles) {
+        if (cycle < m_next_cycle) {
+            m_next_cycle = cycle;
+        }
+    }
+}
+
+void Scheduler::save_state(StateWriter &state) const {
+    state.begin("SCHD");
+    state.write(m_cycle);
+    state.write(m_cycles);
+}
+
+void Scheduler::load_state(StateReader &state) {
+    state.begin("SCHD");
+    state.read(m_cycle);
+    state.read(m_cycles);
+    update_next();
+}
+
+} // nes
\ No newline at end of file
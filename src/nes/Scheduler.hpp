@@ -0,0 +1,92 @@
+/*******************************************************************************
+MIT License
+
+Copyright (c) 2020 Chris Luby
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+/*******************************************************************************
+Schedules bus events (DMA transfers, predicted IRQs) for a specific CPU cycle so
+nothing has to be polled every cycle.  Each event type has at most one pending
+occurrence; scheduling it again moves it.
+*******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+
+#include <nes/State.hpp>
+
+namespace nes {
+
+class Scheduler {
+public:
+    enum Event {
+        OAM_DMA = 0,
+        DMC_DMA,
+        MAPPER_IRQ,
+        NUM_EVENTS
+    };
+
+    static const uint64_t NEVER = UINT64_MAX;
+
+    Scheduler() {
+        reset();
+    }
+
+    void reset();
+
+    // Current CPU cycle
+    const uint64_t now() const {
+        return m_cycle;
+    }
+
+    // Advance by one CPU cycle
+    void tick() {
+        m_cycle++;
+    }
+
+    // True if an event is due at the current cycle
+    const bool pending() const {
+        return m_next_cycle <= m_cycle;
+    }
+
+    void schedule(const Event event, const uint64_t cycle);
+    void cancel(const Event event);
+
+    const uint64_t scheduled(const Event event) const {
+        return m_cycles[event];
+    }
+
+    // Remove and return the earliest due event, false if none are due
+    const bool pop(Event &event);
+
+    void save_state(StateWriter &state) const;
+    void load_state(StateReader &state);
+
+private:
+    uint64_t m_cycle;
+    uint64_t m_cycles[NUM_EVENTS];
+    uint64_t m_next_cycle;
+
+    void update_next();
+};
+
+} // nes
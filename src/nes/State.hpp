@@ -0,0 +1,120 @@
+/*******************************************************************************
+MIT License
+
+Copyright (c) 2020 Chris Luby
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+/*******************************************************************************
+Binary save states.  Every component writes its fields in a fixed order straight
+into one buffer, which is reused from save to save so snapshotting every frame
+doesn't allocate.  Each component's block starts with a four character tag so a
+state from another version or machine fails to load instead of loading garbage.
+States are only meant to be loaded by the same build on the same kind of host.
+*******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+#include <stdexcept>
+#include <type_traits>
+
+#include <utils/string_format.hpp>
+
+namespace nes {
+
+class StateWriter {
+public:
+    // Bump whenever a component adds, removes or reorders a field
+    static const uint32_t VERSION = 1;
+
+    // Empties the buffer but keeps its capacity
+    StateWriter(std::vector<uint8_t> &buffer)
+        : m_buffer(buffer) {
+        m_buffer.clear();
+    }
+
+    void write(const void *data, const size_t size) {
+        const size_t offset = m_buffer.size();
+        m_buffer.resize(offset + size);
+        memcpy(m_buffer.data() + offset, data, size);
+    }
+
+    template <class T>
+    void write(const T &value) {
+        static_assert(std::is_trivially_copyable<T>::value, "Only plain data can be written to a state");
+        write(&value, sizeof(T));
+    }
+
+    // Start of a component's block
+    void begin(const char (&tag)[5]) {
+        write(tag, 4);
+    }
+
+private:
+    std::vector<uint8_t> &m_buffer;
+};
+
+class StateReader {
+public:
+    StateReader(const uint8_t *data, const size_t size)
+        : m_data(data)
+        , m_size(size)
+        , m_offset(0) {
+    }
+
+    // Throws std::runtime_error if the state is too short
+    void read(void *data, const size_t size) {
+        if (size > m_size - m_offset) {
+            throw std::runtime_error(utils::string_format("Save state is truncated at byte %llu", (unsigned long long)m_offset));
+        }
+        memcpy(data, m_data + m_offset, size);
+        m_offset += size;
+    }
+
+    template <class T>
+    void read(T &value) {
+        static_assert(std::is_trivially_copyable<T>::value, "Only plain data can be read from a state");
+        read(&value, sizeof(T));
+    }
+
+    // Throws std::runtime_error if the next block isn't tag
+    void begin(const char (&tag)[5]) {
+        char found[4];
+        read(found, sizeof(found));
+        if (memcmp(found, tag, sizeof(found)) != 0) {
+            throw std::runtime_error(utils::string_format("Save state expected a %s block at byte %llu", tag, (unsigned long long)(m_offset - sizeof(found))));
+        }
+    }
+
+    const bool done() const {
+        return m_offset == m_size;
+    }
+
+private:
+    const uint8_t *m_data;
+    size_t m_size;
+    size_t m_offset;
+};
+
+} // nes
@@ -0,0 +1,57 @@
+/*******************************************************************************
+MIT License
+
+Copyright (c) 2020 Chris Luby
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+/*******************************************************************************
+Clock rates and frame shapes for the different console regions
+
+Links:
+- https://wiki.nesdev.com/w/index.php/Cycle_reference_chart
+- https://wiki.nesdev.com/w/index.php/Clock_rate
+*******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+
+namespace nes {
+
+struct Timing {
+    const char *name;
+
+    // The CPU runs cpu_clocks cycles for every ppu_clocks PPU dots
+    uint32_t cpu_clocks;
+    uint32_t ppu_clocks;
+
+    uint32_t cpu_clock_rate; // Hz
+    uint16_t scanlines; // Per frame, including vblank
+    double frame_rate; // Frames per second
+
+    // The APU uses the PAL frame counter and period tables
+    bool pal_apu;
+};
+
+const Timing NTSC_TIMING = { "NTSC", 1, 3, 1789773, 262, 60.0988, false };
+const Timing PAL_TIMING = { "PAL", 5, 16, 1662607, 312, 50.0070, true };
+const Timing DENDY_TIMING = { "Dendy", 1, 3, 1773448, 312, 50.0070, false };
+
+} // nes
@@ -0,0 +1,108 @@
+/*******************************************************************************
+MIT License
+
+Copyright (c) 2020 Chris Luby
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+/*******************************************************************************
+Many machines stepped together a frame at a time
+*******************************************************************************/
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+
+#include <nes/VecEnv.hpp>
+#include <nes/apu/APURP2A03Headless.hpp>
+#include <nes/cart/Cart.hpp>
+
+namespace nes {
+
+VecEnv::VecEnv(const std::string &rom_filename, const size_t count, const size_t threads, std::shared_ptr<const nes::cart::RomDatabase> database)
+    : m_pool(threads)
+    , m_actions(nullptr)
+    , m_frames(nullptr)
+    , m_ram(nullptr) {
+    m_machines.resize(count);
+    for (auto &machine : m_machines) {
+        auto cpu = std::make_shared<nes::cpu::CPU2A03>();
+        machine.ram = std::make_shared<nes::ram::Ram>();
+        machine.ppu = std::make_shared<nes::ppu::PPU2C02Buffer>();
+        machine.controller = std::make_shared<nes::controller::Controller>();
+        machine.bus = std::make_shared<nes::Bus>(cpu, machine.ram, machine.ppu, std::make_shared<nes::apu::APURP2A03Headless>(), machine.controller);
+        cpu->connect_bus(machine.bus);
+        // Every cart shares the one copy of the ROM
+        machine.bus->load_cart(std::make_shared<nes::cart::Cart>(rom_filename, false, database, false));
+    }
+    m_chunk_size = std::max<size_t>((count + m_pool.size() - 1) / m_pool.size(), 1);
+
+    // A reset of the bus leaves memory alone, so power cycles restore this
+    if (!m_machines.empty()) {
+        m_machines.front().bus->save_state(m_power_on_state);
+    }
+}
+
+void VecEnv::reset() {
+    for (auto &machine : m_machines) {
+        machine.bus->load_state(m_power_on_state);
+    }
+}
+
+void VecEnv::reset(const size_t index) {
+    m_machines[index].bus->load_state(m_power_on_state);
+}
+
+void VecEnv::step(const uint8_t *actions, uint8_t *frames, uint8_t *ram) {
+    m_actions = actions;
+    m_frames = frames;
+    m_ram = ram;
+
+    // Nothing to gain from handing a single chunk to another thread
+    if (m_chunk_size >= m_machines.size()) {
+        step(0, m_machines.size());
+        return;
+    }
+    for (size_t begin = 0; begin < m_machines.size(); begin += m_chunk_size) {
+        m_pool.submit([this, begin] {
+            step(begin, std::min(begin + m_chunk_size, m_machines.size()));
+        });
+    }
+    m_pool.wait();
+}
+
+void VecEnv::step(const size_t begin, const size_t end) {
+    for (size_t i = begin; i < end; i++) {
+        Machine &machine = m_machines[i];
+        machine.controller->set_buttons(0, m_actions != nullptr ? m_actions[i] : 0x00);
+        machine.ppu->set_buffer(m_frames != nullptr ? m_frames + i * FRAME_SIZE : nullptr);
+        machine.bus->set_output_enabled(m_frames != nullptr, false);
+        machine.bus->run_frame();
+        if (m_ram != nullptr) {
+            memcpy(m_ram + i * RAM_SIZE, machine.ram->data(), RAM_SIZE);
+        }
+    }
+}
+
+} // nes
@@ -0,0 +1,96 @@
+/*******************************************************************************
+MIT License
+
+Copyright (c) 2020 Chris Luby
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+/*******************************************************************************
+Many machines running the same ROM, stepped together a frame at a time for
+training agents.  One call sets every machine's player 1 buttons, runs them
+all a frame across a thread pool and has each draw its picture and copy its RAM
+into its slot of buffers the caller owns, so a step costs no allocations and
+the results land in one array per kind ready to wrap (numpy and the like).
+*******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <memory>
+
+#include <utils/ThreadPool.hpp>
+#include <nes/Bus.hpp>
+#include <nes/ppu/PPU2C02Buffer.hpp>
+#include <nes/cart/RomDatabase.hpp>
+
+namespace nes {
+
+class VecEnv {
+public:
+    // Bytes per machine in the buffers given to step()
+    static const size_t FRAME_SIZE = nes::ppu::PPU2C02Buffer::FRAME_SIZE; // 256x240 RGB
+    static const size_t RAM_SIZE = nes::ram::Ram::SIZE;
+
+    // Powers on count machines, the work is split across threads (one per core
+    // when 0).  Throws std::runtime_error if the ROM can't be loaded.  Battery
+    // RAM starts empty and isn't saved.
+    VecEnv(const std::string &rom_filename, const size_t count, const size_t threads = 0, std::shared_ptr<const nes::cart::RomDatabase> database = nullptr);
+
+    const size_t size() const {
+        return m_machines.size();
+    }
+
+    // Power cycle every machine, or just one (its episode ended).  Memory,
+    // including PRG-RAM, CHR-RAM and OAM, goes back to how it was at power on.
+    void reset();
+    void reset(const size_t index);
+
+    // Run every machine one frame holding actions[i] (controller button bits),
+    // then write machine i's frame to frames + i * FRAME_SIZE and its RAM to
+    // ram + i * RAM_SIZE.  Skipped buffers can be nullptr, with no frames the
+    // machines don't draw at all.
+    void step(const uint8_t *actions, uint8_t *frames, uint8_t *ram);
+
+private:
+    struct Machine {
+        std::shared_ptr<nes::ram::Ram> ram;
+        std::shared_ptr<nes::ppu::PPU2C02Buffer> ppu;
+        std::shared_ptr<nes::controller::Controller> controller;
+        std::shared_ptr<nes::Bus> bus;
+    };
+
+    std::vector<Machine> m_machines;
+    utils::ThreadPool m_pool;
+    size_t m_chunk_size; // Machines per task, one task per thread
+    std::vector<uint8_t> m_power_on_state; // Every machine as constructed
+
+    // The step in progress, shared with the tasks rather than captured so
+    // submitting them doesn't allocate
+    const uint8_t *m_actions;
+    uint8_t *m_frames;
+    uint8_t *m_ram;
+
+    void step(const size_t begin, const size_t end);
+};
+
+} // nes
@@ -28,29 +28,628 @@ the Nintendo Entertainment System
 
 Links:
 - https://wiki.nesdev.com/w/index.php/APU
+- https://wiki.nesdev.com/w/index.php/APU_Frame_Counter
 *******************************************************************************/
 
 #include <cstdint>
+#include <algorithm>
 
 #include <nes/apu/APURP2A03.hpp>
+#include <nes/apu/APURP2A03Mixer.hpp>
 
 namespace nes { namespace apu {
 
+const uint8_t APURP2A03::LENGTH_TABLE[32] = {
+    10, 254, 20,  2, 40,  4, 80,  6, 160,  8, 60, 10, 14, 12, 26, 14,
+    12,  16, 24, 18, 48, 20, 96, 22, 192, 24, 72, 26, 16, 28, 32, 30
+};
+
+const uint8_t APURP2A03::DUTY_TABLE[4][8] = {
+    { 0, 1, 0, 0, 0, 0, 0, 0 }, // 12.5%
+    { 0, 1, 1, 0, 0, 0, 0, 0 }, // 25%
+    { 0, 1, 1, 1, 1, 0, 0, 0 }, // 50%
+    { 1, 0, 0, 1, 1, 1, 1, 1 }  // 25% negated
+};
+
+const uint8_t APURP2A03::TRIANGLE_TABLE[32] = {
+    15, 14, 13, 12, 11, 10,  9,  8,  7,  6,  5,  4,  3,  2,  1,  0,
+     0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15
+};
+
+const APURP2A03::RegionTables APURP2A03::NTSC_TABLES = {
+    { 4, 8, 16, 32, 64, 96, 128, 160, 202, 254, 380, 508, 762, 1016, 2034, 4068 },
+    { 428, 380, 340, 320, 286, 254, 226, 214, 190, 160, 142, 128, 106, 84, 72, 54 },
+    { 7457, 14913, 22371, 29829 },
+    { 7457, 14913, 22371, 29829, 37281 },
+    29830,
+    37282
+};
+
+const APURP2A03::RegionTables APURP2A03::PAL_TABLES = {
+    { 4, 8, 14, 30, 60, 88, 118, 148, 188, 236, 354, 472, 708, 944, 1890, 3778 },
+    { 398, 354, 316, 298, 276, 236, 210, 198, 176, 148, 132, 118, 98, 78, 66, 50 },
+    { 8313, 16627, 24939, 33253 },
+    { 8313, 16627, 24939, 33253, 41565 },
+    33254,
+    41566
+};
+
+void APURP2A03::set_timing(const nes::Timing &timing) {
+    m_tables = timing.pal_apu ? &PAL_TABLES : &NTSC_TABLES;
+    m_cpu_clock_rate = timing.cpu_clock_rate;
+}
+
 void APURP2A03::reset() {
+    m_pulse[0] = Pulse();
+    m_pulse[0].ones_complement = true;
+    m_pulse[1] = Pulse();
+    m_triangle = Triangle();
+    m_noise = Noise();
+    m_dmc = DMC();
+
+    m_pulse[0].timer = m_pulse[1].timer = 2;
+    m_triangle.timer = 1;
+    m_noise.period = m_noise.timer = m_tables->noise_period[0];
+    m_dmc.rate = m_dmc.timer = m_tables->dmc_rate[0];
+
+    m_frame_mode_5 = false;
+    m_frame_irq_inhibit = false;
+    m_frame_irq = false;
+    m_frame_cycle = 0;
+    m_frame_step = 0;
+
+    m_cycle = m_clock_count;
+    m_sample_accumulator = 0;
+    m_num_samples = 0;
+
+    predict_events();
+}
+
+void APURP2A03::save_state(StateWriter &state) const {
+    state.begin("APU ");
+    Component::save_state(state);
+    state.write(m_pulse);
+    state.write(m_triangle);
+    state.write(m_noise);
+    state.write(m_dmc);
+    state.write(m_frame_mode_5);
+    state.write(m_frame_irq_inhibit);
+    state.write(m_frame_irq);
+    state.write(m_frame_cycle);
+    state.write(m_frame_step);
+    state.write(m_cycle);
+    state.write(m_next_irq_cycle);
+    state.write(m_next_dmc_fetch_cycle);
+    state.write(m_sample_accumulator);
+}
+
+void APURP2A03::load_state(StateReader &state) {
+    state.begin("APU ");
+    Component::load_state(state);
+    state.read(m_pulse);
+    state.read(m_triangle);
+    state.read(m_noise);
+    state.read(m_dmc);
+    state.read(m_frame_mode_5);
+    state.read(m_frame_irq_inhibit);
+    state.read(m_frame_irq);
+    state.read(m_frame_cycle);
+    state.read(m_frame_step);
+    state.read(m_cycle);
+    state.read(m_next_irq_cycle);
+    state.read(m_next_dmc_fetch_cycle);
+    state.read(m_sample_accumulator);
 }
 
 void APURP2A03::clock() {
     Component::clock();
+
+    // Nothing is synthesized here unless an IRQ is due so the CPU sees it on time
+    if (m_clock_count >= m_next_irq_cycle) {
+        run_until(m_clock_count);
+        predict_events();
+    }
 }
 
 const bool APURP2A03::cpu_read(const uint16_t addr, uint8_t &data, const bool read_only) {
     data = 0x00;
 
+    if (addr == ADDR_STATUS) {
+        run_until(m_clock_count);
+
+        data = (m_pulse[0].length > 0 ? 0x01 : 0x00)
+            | (m_pulse[1].length > 0 ? 0x02 : 0x00)
+            | (m_triangle.length > 0 ? 0x04 : 0x00)
+            | (m_noise.length > 0 ? 0x08 : 0x00)
+            | (m_dmc.bytes_remaining > 0 ? 0x10 : 0x00)
+            | (m_frame_irq ? 0x40 : 0x00)
+            | (m_dmc.irq ? 0x80 : 0x00);
+
+        // Reading the status acknowledges the frame IRQ
+        if (!read_only) {
+            m_frame_irq = false;
+            predict_events();
+        }
+    }
+
     return true;
 }
 
 const bool APURP2A03::cpu_write(const uint16_t addr, const uint8_t data) {
+    // Everything up to this write is synthesized with the old register values
+    run_until(m_clock_count);
+
+    if (addr >= ADDR_PULSE1_BEGIN && addr <= ADDR_PULSE1_END) {
+        write_pulse(m_pulse[0], addr - ADDR_PULSE1_BEGIN, data);
+    } else if (addr >= ADDR_PULSE2_BEGIN && addr <= ADDR_PULSE2_END) {
+        write_pulse(m_pulse[1], addr - ADDR_PULSE2_BEGIN, data);
+    } else if (addr >= ADDR_TRIANGLE_BEGIN && addr <= ADDR_TRIANGLE_END) {
+        switch (addr - ADDR_TRIANGLE_BEGIN) {
+            case 0:
+                m_triangle.control = (data & 0x80) != 0;
+                m_triangle.linear_reload_value = data & 0x7F;
+                break;
+            case 2:
+                m_triangle.period = (m_triangle.period & 0x0700) | data;
+                break;
+            case 3:
+                m_triangle.period = (m_triangle.period & 0x00FF) | ((uint16_t)(data & 0x07) << 8);
+                if (m_triangle.enabled) {
+                    m_triangle.length = LENGTH_TABLE[data >> 3];
+                }
+                m_triangle.linear_reload = true;
+                break;
+        }
+    } else if (addr >= ADDR_NOISE_BEGIN && addr <= ADDR_NOISE_END) {
+        switch (addr - ADDR_NOISE_BEGIN) {
+            case 0:
+                m_noise.length_halt = m_noise.envelope.loop = (data & 0x20) != 0;
+                m_noise.envelope.constant = (data & 0x10) != 0;
+                m_noise.envelope.volume = data & 0x0F;
+                break;
+            case 2:
+                m_noise.mode = (data & 0x80) != 0;
+                m_noise.period = m_tables->noise_period[data & 0x0F];
+                break;
+            case 3:
+                if (m_noise.enabled) {
+                    m_noise.length = LENGTH_TABLE[data >> 3];
+                }
+                m_noise.envelope.start = true;
+                break;
+        }
+    } else if (addr >= ADDR_DMC_BEGIN && addr <= ADDR_DMC_END) {
+        switch (addr - ADDR_DMC_BEGIN) {
+            case 0:
+                m_dmc.irq_enabled = (data & 0x80) != 0;
+                if (!m_dmc.irq_enabled) {
+                    m_dmc.irq = false;
+                }
+                m_dmc.loop = (data & 0x40) != 0;
+                m_dmc.rate = m_tables->dmc_rate[data & 0x0F];
+                break;
+            case 1:
+                m_dmc.level = data & 0x7F;
+                break;
+            case 2:
+                m_dmc.sample_addr = 0xC000 | ((uint16_t)data << 6);
+                break;
+            case 3:
+                m_dmc.sample_length = ((uint16_t)data << 4) | 0x0001;
+                break;
+        }
+    } else if (addr == ADDR_STATUS) {
+        m_pulse[0].enabled = (data & 0x01) != 0;
+        m_pulse[1].enabled = (data & 0x02) != 0;
+        m_triangle.enabled = (data & 0x04) != 0;
+        m_noise.enabled = (data & 0x08) != 0;
+        if (!m_pulse[0].enabled) m_pulse[0].length = 0;
+        if (!m_pulse[1].enabled) m_pulse[1].length = 0;
+        if (!m_triangle.enabled) m_triangle.length = 0;
+        if (!m_noise.enabled) m_noise.length = 0;
+
+        m_dmc.irq = false;
+        if (data & 0x10) {
+            // If the buffer is empty the bus will fetch right away
+            if (m_dmc.bytes_remaining == 0) {
+                dmc_restart();
+            }
+        } else {
+            m_dmc.bytes_remaining = 0;
+        }
+    } else if (addr == ADDR_FRAME_COUNTER) {
+        m_frame_mode_5 = (data & 0x80) != 0;
+        m_frame_irq_inhibit = (data & 0x40) != 0;
+        if (m_frame_irq_inhibit) {
+            m_frame_irq = false;
+        }
+
+        // Writing restarts the sequencer, 5 step mode clocks everything right away
+        m_frame_cycle = 0;
+        m_frame_step = 0;
+        if (m_frame_mode_5) {
+            clock_quarter_frame();
+            clock_half_frame();
+        }
+    }
+
+    predict_events();
+
     return true;
 }
 
-}} // nes::apu
\ No newline at end of file
+void APURP2A03::end_frame() {
+    run_until(m_clock_count);
+    predict_events();
+    if (m_output_enabled) {
+        flush_samples();
+        close_frame();
+    }
+}
+
+const uint64_t APURP2A03::cycles_until_dmc_fetch() const {
+    if (m_next_dmc_fetch_cycle == NEVER) {
+        return NEVER;
+    }
+    return m_next_dmc_fetch_cycle > m_clock_count ? m_next_dmc_fetch_cycle - m_clock_count : 0;
+}
+
+/**
+ * The bus has read the next sample byte on the predicted cycle
+ */
+void APURP2A03::dmc_dma(const uint8_t data) {
+    run_until(m_clock_count);
+
+    if (m_dmc.buffer_empty && m_dmc.bytes_remaining > 0) {
+        m_dmc.buffer = data;
+        m_dmc.buffer_empty = false;
+
+        // Address wraps around to $8000 rather than $0000
+        m_dmc.current_addr = m_dmc.current_addr == 0xFFFF ? 0x8000 : m_dmc.current_addr + 1;
+        m_dmc.bytes_remaining--;
+        if (m_dmc.bytes_remaining == 0) {
+            if (m_dmc.loop) {
+                dmc_restart();
+            } else if (m_dmc.irq_enabled) {
+                m_dmc.irq = true;
+            }
+        }
+    }
+
+    predict_events();
+}
+
+namespace {
+
+/**
+ * Count a timer down by span cycles, reloading it with period every time it
+ * expires, and return how many times it expired
+ */
+const uint64_t advance_timer(uint32_t &timer, const uint32_t period, const uint64_t span) {
+    if (span < timer) {
+        timer -= (uint32_t)span;
+        return 0;
+    }
+    const uint64_t remainder = span - timer;
+    timer = period - (uint32_t)(remainder % period);
+    return 1 + remainder / period;
+}
+
+/**
+ * Shift the noise LFSR steps times.  Each new bit is bit 0 xor the tap, so the
+ * next 15 - tap bits only depend on bits already in the register and can all be
+ * worked out in one go.
+ */
+const uint16_t advance_noise(uint16_t shift, const bool mode, uint64_t steps) {
+    const uint32_t tap = mode ? 6 : 1;
+    const uint32_t chunk = 15 - tap;
+    for (; steps >= chunk; steps -= chunk) {
+        const uint16_t feedback = (shift ^ (shift >> tap)) & ((1 << chunk) - 1);
+        shift = (shift >> chunk) | (feedback << tap);
+    }
+    for (; steps > 0; steps--) {
+        const uint16_t feedback = (shift ^ (shift >> tap)) & 0x0001;
+        shift = (shift >> 1) | (feedback << 14);
+    }
+    return shift;
+}
+
+} // anonymous
+
+/**
+ * Synthesize every channel from m_cycle up to cycle.  Rather than stepping one
+ * cycle at a time, jump straight to the next frame counter step, output sample
+ * or active DMC bit, whichever comes first.  Channel outputs are only looked at
+ * when a sample is taken so the pulse, triangle and noise sequencers are
+ * fast-forwarded over the whole span, and an idle DMC just counts bits.
+ */
+void APURP2A03::run_until(const uint64_t cycle) {
+    while (m_cycle < cycle) {
+        const bool triangle_running = m_triangle.length > 0 && m_triangle.linear > 0 && m_triangle.period >= 2;
+        // With nothing to play the DMC only counts down bits, it can't change level or need a fetch
+        const bool dmc_idle = m_dmc.silence && m_dmc.buffer_empty && m_dmc.bytes_remaining == 0;
+        const uint32_t frame_next = m_frame_mode_5 ?
+            (m_frame_step < 5 ? m_tables->frame_step_5[m_frame_step] : m_tables->frame_period_5) :
+            (m_frame_step < 4 ? m_tables->frame_step_4[m_frame_step] : m_tables->frame_period_4);
+        const uint64_t sample_next = m_output_enabled ? (m_cpu_clock_rate - m_sample_accumulator + SAMPLE_RATE - 1) / SAMPLE_RATE : NEVER;
+
+        uint64_t span = cycle - m_cycle;
+        if (!dmc_idle) {
+            span = std::min<uint64_t>(span, m_dmc.timer);
+        }
+        span = std::min<uint64_t>(span, frame_next - m_frame_cycle);
+        span = std::min<uint64_t>(span, sample_next);
+
+        m_cycle += span;
+        m_frame_cycle += (uint32_t)span;
+        m_sample_accumulator += span * SAMPLE_RATE;
+
+        for (auto &pulse : m_pulse) {
+            const uint64_t steps = advance_timer(pulse.timer, ((uint32_t)pulse.period + 1) * 2, span);
+            pulse.step = (uint8_t)((pulse.step + steps) & 0x07);
+        }
+
+        if (triangle_running) {
+            const uint64_t steps = advance_timer(m_triangle.timer, (uint32_t)m_triangle.period + 1, span);
+            m_triangle.step = (uint8_t)((m_triangle.step + steps) & 0x1F);
+        }
+
+        m_noise.shift = advance_noise(m_noise.shift, m_noise.mode, advance_timer(m_noise.timer, m_noise.period, span));
+
+        if (dmc_idle) {
+            const uint64_t bits = advance_timer(m_dmc.timer, m_dmc.rate, span);
+            m_dmc.bits_remaining = (uint8_t)((m_dmc.bits_remaining + 7 - bits % 8) % 8 + 1);
+        } else if (m_dmc.timer == span) {
+            m_dmc.timer = m_dmc.rate;
+            clock_dmc_output();
+        } else {
+            m_dmc.timer -= (uint32_t)span;
+        }
+
+        if (m_frame_cycle == frame_next) {
+            clock_frame_step();
+        }
+
+        if (m_sample_accumulator >= m_cpu_clock_rate) {
+            if (m_output_enabled) {
+                m_sample_accumulator -= m_cpu_clock_rate;
+                emit_sample();
+            } else {
+                // Keep the sample phase so output picks up where it would have
+                m_sample_accumulator %= m_cpu_clock_rate;
+            }
+        }
+    }
+}
+
+/**
+ * Work out the earliest cycle the frame counter will raise an IRQ so clock()
+ * knows when it has to catch up, and when the DMC sample buffer will need to
+ * be refilled by the bus.  Every register access re-predicts.
+ */
+void APURP2A03::predict_events() {
+    m_next_irq_cycle = NEVER;
+    m_next_dmc_fetch_cycle = NEVER;
+
+    if (!m_frame_mode_5 && !m_frame_irq_inhibit && !m_frame_irq) {
+        const uint32_t irq_cycle = m_tables->frame_step_4[3];
+        if (m_frame_step <= 3) {
+            m_next_irq_cycle = m_cycle + (irq_cycle - m_frame_cycle);
+        } else {
+            m_next_irq_cycle = m_cycle + (m_tables->frame_period_4 - m_frame_cycle) + irq_cycle;
+        }
+    }
+
+    if (m_dmc.bytes_remaining > 0) {
+        if (m_dmc.buffer_empty) {
+            m_next_dmc_fetch_cycle = m_cycle;
+        } else {
+            // The buffer is emptied when the next output cycle starts
+            m_next_dmc_fetch_cycle = m_cycle + m_dmc.timer + (uint64_t)(m_dmc.bits_remaining - 1) * m_dmc.rate;
+        }
+    }
+}
+
+void APURP2A03::clock_frame_step() {
+    if (m_frame_mode_5) {
+        if (m_frame_step >= 5) {
+            m_frame_cycle = 0;
+            m_frame_step = 0;
+            return;
+        }
+        switch (m_frame_step) {
+            case 0: case 2: clock_quarter_frame(); break;
+            case 1: case 4: clock_quarter_frame(); clock_half_frame(); break;
+        }
+    } else {
+        if (m_frame_step >= 4) {
+            m_frame_cycle = 0;
+            m_frame_step = 0;
+            return;
+        }
+        switch (m_frame_step) {
+            case 0: case 2: clock_quarter_frame(); break;
+            case 1: clock_quarter_frame(); clock_half_frame(); break;
+            case 3:
+                clock_quarter_frame();
+                clock_half_frame();
+                if (!m_frame_irq_inhibit) {
+                    m_frame_irq = true;
+                }
+                break;
+        }
+    }
+    m_frame_step++;
+}
+
+void APURP2A03::clock_quarter_frame() {
+    m_pulse[0].envelope.clock();
+    m_pulse[1].envelope.clock();
+    m_noise.envelope.clock();
+
+    if (m_triangle.linear_reload) {
+        m_triangle.linear = m_triangle.linear_reload_value;
+    } else if (m_triangle.linear > 0) {
+        m_triangle.linear--;
+    }
+    if (!m_triangle.control) {
+        m_triangle.linear_reload = false;
+    }
+}
+
+void APURP2A03::clock_half_frame() {
+    for (auto &pulse : m_pulse) {
+        if (pulse.length > 0 && !pulse.length_halt) {
+            pulse.length--;
+        }
+        pulse.clock_sweep();
+    }
+    if (m_triangle.length > 0 && !m_triangle.control) {
+        m_triangle.length--;
+    }
+    if (m_noise.length > 0 && !m_noise.length_halt) {
+        m_noise.length--;
+    }
+}
+
+void APURP2A03::clock_dmc_output() {
+    if (!m_dmc.silence) {
+        if (m_dmc.shift & 0x01) {
+            if (m_dmc.level <= 125) {
+                m_dmc.level += 2;
+            }
+        } else if (m_dmc.level >= 2) {
+            m_dmc.level -= 2;
+        }
+        m_dmc.shift >>= 1;
+    }
+
+    m_dmc.bits_remaining--;
+    if (m_dmc.bits_remaining == 0) {
+        // Start a new output cycle
+        m_dmc.bits_remaining = 8;
+        if (m_dmc.buffer_empty) {
+            m_dmc.silence = true;
+        } else {
+            m_dmc.silence = false;
+            m_dmc.shift = m_dmc.buffer;
+            m_dmc.buffer_empty = true;
+        }
+    }
+}
+
+void APURP2A03::dmc_restart() {
+    m_dmc.current_addr = m_dmc.sample_addr;
+    m_dmc.bytes_remaining = m_dmc.sample_length;
+}
+
+void APURP2A03::write_pulse(Pulse &pulse, const uint16_t reg, const uint8_t data) {
+    switch (reg) {
+        case 0:
+            pulse.duty = data >> 6;
+            pulse.length_halt = pulse.envelope.loop = (data & 0x20) != 0;
+            pulse.envelope.constant = (data & 0x10) != 0;
+            pulse.envelope.volume = data & 0x0F;
+            break;
+        case 1:
+            pulse.sweep_enabled = (data & 0x80) != 0;
+            pulse.sweep_period = (data >> 4) & 0x07;
+            pulse.sweep_negate = (data & 0x08) != 0;
+            pulse.sweep_shift = data & 0x07;
+            pulse.sweep_reload = true;
+            break;
+        case 2:
+            pulse.period = (pulse.period & 0x0700) | data;
+            break;
+        case 3:
+            pulse.period = (pulse.period & 0x00FF) | ((uint16_t)(data & 0x07) << 8);
+            if (pulse.enabled) {
+                pulse.length = LENGTH_TABLE[data >> 3];
+            }
+            pulse.step = 0;
+            pulse.envelope.start = true;
+            break;
+    }
+}
+
+void APURP2A03::emit_sample() {
+    m_channels.pulse1[m_num_samples] = m_pulse[0].output();
+    m_channels.pulse2[m_num_samples] = m_pulse[1].output();
+    m_channels.triangle[m_num_samples] = m_triangle.output();
+    m_channels.noise[m_num_samples] = m_noise.output();
+    m_channels.dmc[m_num_samples] = m_dmc.level;
+
+    m_num_samples++;
+    if (m_num_samples >= SAMPLE_BUFFER_SIZE) {
+        flush_samples();
+    }
+}
+
+void APURP2A03::flush_samples() {
+    if (m_num_samples > 0) {
+        APURP2A03Mixer::mix(
+            m_channels.pulse1, m_channels.pulse2, m_channels.triangle, m_channels.noise, m_channels.dmc,
+            m_samples, m_num_samples
+        );
+        output_samples(m_channels, m_samples, m_num_samples);
+        m_num_samples = 0;
+    }
+}
+
+void APURP2A03::Envelope::clock() {
+    if (start) {
+        start = false;
+        decay = 15;
+        divider = volume;
+    } else if (divider == 0) {
+        divider = volume;
+        if (decay > 0) {
+            decay--;
+        } else if (loop) {
+            decay = 15;
+        }
+    } else {
+        divider--;
+    }
+}
+
+const uint16_t APURP2A03::Pulse::sweep_target() const {
+    const int32_t change = period >> sweep_shift;
+    if (sweep_negate) {
+        return (uint16_t)std::max<int32_t>(0, (int32_t)period - change - (ones_complement ? 1 : 0));
+    }
+    return (uint16_t)(period + change);
+}
+
+void APURP2A03::Pulse::clock_sweep() {
+    const uint16_t target = sweep_target();
+    if (sweep_divider == 0 && sweep_enabled && sweep_shift > 0 && period >= 8 && target <= 0x07FF) {
+        period = target;
+    }
+    if (sweep_divider == 0 || sweep_reload) {
+        sweep_divider = sweep_period;
+        sweep_reload = false;
+    } else {
+        sweep_divider--;
+    }
+}
+
+const uint8_t APURP2A03::Pulse::output() const {
+    if (length == 0 || period < 8 || sweep_target() > 0x07FF || !DUTY_TABLE[duty][step]) {
+        return 0;
+    }
+    return envelope.output();
+}
+
+const uint8_t APURP2A03::Triangle::output() const {
+    return TRIANGLE_TABLE[step];
+}
+
+const uint8_t APURP2A03::Noise::output() const {
+    if (length == 0 || (shift & 0x0001)) {
+        return 0;
+    }
+    return envelope.output();
+}
+
+}} // nes::apu
@@ -26,31 +26,229 @@ SOFTWARE.
 Emulation of the RP2A03 used as the Audio Processing Unit for the NTSC flavor of
 the Nintendo Entertainment System
 
+The APU runs in catch-up mode.  Clocking it only advances a cycle counter; the
+channels are synthesized in one go for the span since the last catch-up when a
+register is written, the status register is read, the frame ends, a predicted
+frame counter IRQ comes due, or the bus performs a predicted DMC sample fetch.
+
 Links:
 - https://wiki.nesdev.com/w/index.php/APU
+- https://wiki.nesdev.com/w/index.php/APU_Frame_Counter
+- https://wiki.nesdev.com/w/index.php/APU_Mixer
 *******************************************************************************/
 
 #pragma once
 
 #include <cstdint>
+#include <cstddef>
 
 #include <nes/Component.hpp>
+#include <nes/Timing.hpp>
 
 namespace nes { namespace apu {
 
 class APURP2A03 : public Component {
 public:
+    static const uint32_t SAMPLE_RATE = 44100;
+    // No event coming, e.g. from cycles_until_dmc_fetch()
+    static const uint64_t NEVER = UINT64_MAX;
+
     void reset() override;
 
+    // Pick the clock rate and period tables for the console region, before reset()
+    void set_timing(const nes::Timing &timing);
+
+    // Only counts cycles, synthesis happens lazily in run_until()
     void clock() override;
 
     const bool cpu_read(const uint16_t addr, uint8_t &data, const bool read_only = false) override;
     const bool cpu_write(const uint16_t addr, const uint8_t data) override;
 
+    // Channel and frame counter state, samples not yet handed off aren't saved
+    void save_state(StateWriter &state) const override;
+    void load_state(StateReader &state) override;
+
+    // Catch up to the current cycle and hand off all pending samples
+    void end_frame();
+
+    // Speculative frames (run-ahead) still run the channels but produce no samples
+    void set_output_enabled(const bool enabled) {
+        m_output_enabled = enabled;
+    }
+
+    // DMC sample fetches are performed by the bus as DMA
+    const uint64_t cycles_until_dmc_fetch() const;
+    const uint16_t dmc_fetch_addr() const {
+        return m_dmc.current_addr;
+    }
+    void dmc_dma(const uint8_t data);
+
+    // State of the IRQ line driven by the frame counter and DMC
+    const bool irq() const {
+        return m_frame_irq || m_dmc.irq;
+    }
+
 protected:
+    static const size_t SAMPLE_BUFFER_SIZE = 1024;
 
-private:
+    // Output of each channel for every sample, before mixing
+    struct ChannelBlock {
+        uint8_t pulse1[SAMPLE_BUFFER_SIZE];
+        uint8_t pulse2[SAMPLE_BUFFER_SIZE];
+        uint8_t triangle[SAMPLE_BUFFER_SIZE];
+        uint8_t noise[SAMPLE_BUFFER_SIZE];
+        uint8_t dmc[SAMPLE_BUFFER_SIZE];
+    };
 
+    virtual void output_samples(const ChannelBlock &channels, const float *samples, const size_t count) = 0;
+    virtual void close_frame() = 0;
+
+private:
+    static const uint16_t ADDR_PULSE1_BEGIN = 0x4000; static const uint16_t ADDR_PULSE1_END = 0x4003;
+    static const uint16_t ADDR_PULSE2_BEGIN = 0x4004; static const uint16_t ADDR_PULSE2_END = 0x4007;
+    static const uint16_t ADDR_TRIANGLE_BEGIN = 0x4008; static const uint16_t ADDR_TRIANGLE_END = 0x400B;
+    static const uint16_t ADDR_NOISE_BEGIN = 0x400C; static const uint16_t ADDR_NOISE_END = 0x400F;
+    static const uint16_t ADDR_DMC_BEGIN = 0x4010; static const uint16_t ADDR_DMC_END = 0x4013;
+    static const uint16_t ADDR_STATUS = 0x4015;
+    static const uint16_t ADDR_FRAME_COUNTER = 0x4017;
+
+    static const uint8_t LENGTH_TABLE[32];
+    static const uint8_t DUTY_TABLE[4][8];
+    static const uint8_t TRIANGLE_TABLE[32];
+
+    // Periods that differ between NTSC and PAL consoles
+    struct RegionTables {
+        uint16_t noise_period[16];
+        uint16_t dmc_rate[16];
+
+        // Frame counter steps in CPU cycles since the sequencer was last reset
+        uint32_t frame_step_4[4];
+        uint32_t frame_step_5[5];
+        uint32_t frame_period_4;
+        uint32_t frame_period_5;
+    };
+    static const RegionTables NTSC_TABLES;
+    static const RegionTables PAL_TABLES;
+
+    const RegionTables *m_tables = &NTSC_TABLES;
+    uint32_t m_cpu_clock_rate = nes::NTSC_TIMING.cpu_clock_rate;
+
+    struct Envelope {
+        bool start = false;
+        bool loop = false;
+        bool constant = false;
+        uint8_t volume = 0;
+        uint8_t divider = 0;
+        uint8_t decay = 0;
+
+        void clock();
+        const uint8_t output() const {
+            return constant ? volume : decay;
+        }
+    };
+
+    struct Pulse {
+        bool enabled = false;
+        bool ones_complement = false; // Pulse 1 negates with ones' complement
+        uint8_t duty = 0;
+        uint8_t step = 0;
+        uint16_t period = 0;
+        uint32_t timer = 0; // CPU cycles until the next sequencer step
+        uint8_t length = 0;
+        bool length_halt = false;
+        Envelope envelope;
+
+        bool sweep_enabled = false;
+        bool sweep_negate = false;
+        bool sweep_reload = false;
+        uint8_t sweep_period = 0;
+        uint8_t sweep_shift = 0;
+        uint8_t sweep_divider = 0;
+
+        const uint16_t sweep_target() const;
+        void clock_sweep();
+        const uint8_t output() const;
+    } m_pulse[2];
+
+    struct Triangle {
+        bool enabled = false;
+        uint8_t step = 0;
+        uint16_t period = 0;
+        uint32_t timer = 0;
+        uint8_t length = 0;
+        bool control = false; // Also the length counter halt
+        bool linear_reload = false;
+        uint8_t linear_reload_value = 0;
+        uint8_t linear = 0;
+
+        const uint8_t output() const;
+    } m_triangle;
+
+    struct Noise {
+        bool enabled = false;
+        bool mode = false;
+        uint16_t shift = 1;
+        uint16_t period = 0;
+        uint32_t timer = 0;
+        uint8_t length = 0;
+        bool length_halt = false;
+        Envelope envelope;
+
+        const uint8_t output() const;
+    } m_noise;
+
+    struct DMC {
+        bool irq_enabled = false;
+        bool irq = false;
+        bool loop = false;
+        uint16_t rate = 0;
+        uint32_t timer = 0;
+        uint8_t level = 0;
+        uint16_t sample_addr = 0;
+        uint16_t sample_length = 0;
+        uint16_t current_addr = 0;
+        uint16_t bytes_remaining = 0;
+        uint8_t buffer = 0;
+        bool buffer_empty = true;
+        uint8_t shift = 0;
+        uint8_t bits_remaining = 8;
+        bool silence = true;
+    } m_dmc;
+
+    bool m_frame_mode_5 = false;
+    bool m_frame_irq_inhibit = false;
+    bool m_frame_irq = false;
+    uint32_t m_frame_cycle = 0;
+    uint8_t m_frame_step = 0;
+
+    // Cycle the channels have been synthesized up to
+    uint64_t m_cycle = 0;
+    // Earliest cycle a frame counter IRQ can be raised
+    uint64_t m_next_irq_cycle = NEVER;
+    // Cycle the DMC sample buffer needs to be refilled
+    uint64_t m_next_dmc_fetch_cycle = NEVER;
+
+    // Channel outputs are collected per sample and mixed a block at a time
+    bool m_output_enabled = true;
+    uint64_t m_sample_accumulator = 0;
+    ChannelBlock m_channels;
+    float m_samples[SAMPLE_BUFFER_SIZE];
+    size_t m_num_samples = 0;
+
+    void run_until(const uint64_t cycle);
+    void predict_events();
+
+    void clock_frame_step();
+    void clock_quarter_frame();
+    void clock_half_frame();
+
+    void clock_dmc_output();
+    void dmc_restart();
+
+    void write_pulse(Pulse &pulse, const uint16_t reg, const uint8_t data);
+
+    void emit_sample();
+    void flush_samples();
 };
 
-}} // nes::apu
\ No newline at end of file
+}} // nes::apu
@@ -23,11 +23,33 @@ SOFTWARE.
 *******************************************************************************/
 
 /*******************************************************************************
-Headless APU emulation
+Headless APU emulation, optionally capturing the mixed output to a WAV file
 *******************************************************************************/
 
+#include <utils/fnv1a.hpp>
 #include <nes/apu/APURP2A03Headless.hpp>
 
 namespace nes { namespace apu {
 
+void APURP2A03Headless::output_samples(const ChannelBlock &channels, const float *samples, const size_t count) {
+    m_hashes.pulse1 = utils::fnv1a_64(channels.pulse1, count, m_hashes.pulse1);
+    m_hashes.pulse2 = utils::fnv1a_64(channels.pulse2, count, m_hashes.pulse2);
+    m_hashes.triangle = utils::fnv1a_64(channels.triangle, count, m_hashes.triangle);
+    m_hashes.noise = utils::fnv1a_64(channels.noise, count, m_hashes.noise);
+    m_hashes.dmc = utils::fnv1a_64(channels.dmc, count, m_hashes.dmc);
+
+    if (m_wav_writer != nullptr) {
+        m_wav_writer->write(samples, count);
+    }
+}
+
+void APURP2A03Headless::close_frame() {
+    m_frame_hashes = m_hashes;
+    reset_hashes();
+}
+
+void APURP2A03Headless::reset_hashes() {
+    m_hashes.pulse1 = m_hashes.pulse2 = m_hashes.triangle = m_hashes.noise = m_hashes.dmc = utils::FNV1A_64_OFFSET;
+}
+
 }} // nes::apu
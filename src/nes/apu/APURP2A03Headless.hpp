@@ -23,21 +23,62 @@ SOFTWARE.
 *******************************************************************************/
 
 /*******************************************************************************
-Headless APU emulation
+Headless APU emulation, optionally capturing the mixed output to a WAV file.
+
+Each channel's output is hashed per frame so regression runs can compare a few
+values against golden files and see exactly which channel changed.
 *******************************************************************************/
 
 #pragma once
 
+#include <cstdint>
+#include <string>
+#include <memory>
+
 #include <nes/apu/APURP2A03.hpp>
+#include <nes/apu/WavWriter.hpp>
 
 namespace nes { namespace apu {
 
 class APURP2A03Headless : public APURP2A03 {
 public:
+    struct ChannelHashes {
+        uint64_t pulse1;
+        uint64_t pulse2;
+        uint64_t triangle;
+        uint64_t noise;
+        uint64_t dmc;
+    };
+
+    APURP2A03Headless() {
+        reset_hashes();
+    }
+    APURP2A03Headless(const std::string &wav_filename)
+        : m_wav_writer(std::make_unique<WavWriter>(wav_filename, SAMPLE_RATE)) {
+        reset_hashes();
+    }
+    // Carries on from where another APU is (forking), without writing a WAV
+    APURP2A03Headless(const APURP2A03 &apu)
+        : APURP2A03(apu) {
+        reset_hashes();
+    }
+
+    // Hashes of every channel over the last completed frame
+    const ChannelHashes &frame_hashes() const {
+        return m_frame_hashes;
+    }
 
 protected:
+    void output_samples(const ChannelBlock &channels, const float *samples, const size_t count) override;
+    void close_frame() override;
 
 private:
+    std::unique_ptr<WavWriter> m_wav_writer;
+
+    ChannelHashes m_hashes;
+    ChannelHashes m_frame_hashes = {};
+
+    void reset_hashes();
 
 };
 
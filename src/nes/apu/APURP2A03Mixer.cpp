@@ -0,0 +1,128 @@
+/*******************************************************************************
+MIT License
+
+Copyright (c) 2020 Chris Luby
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+/*******************************************************************************
+Nonlinear mixer for the RP2A03 channels
+
+Links:
+- https://wiki.nesdev.com/w/index.php/APU_Mixer
+*******************************************************************************/
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <utility>
+#include <type_traits>
+
+#include <nes/apu/APURP2A03Mixer.hpp>
+
+namespace nes { namespace apu {
+
+namespace {
+
+const size_t PULSE_TABLE_SIZE = 31; // pulse1 + pulse2 = 0 - 30
+const size_t TND_TABLE_SIZE = 203; // 3 * triangle + 2 * noise + dmc = 0 - 202
+
+constexpr double pulse_out(const uint32_t pulse) {
+    return pulse == 0 ? 0.0 : 95.88 / (8128.0 / pulse + 100.0);
+}
+
+constexpr double tnd_out(const uint32_t triangle, const uint32_t noise, const uint32_t dmc) {
+    const double sum = triangle / 8227.0 + noise / 12241.0 + dmc / 22638.0;
+    return sum == 0.0 ? 0.0 : 159.79 / (1.0 / sum + 100.0);
+}
+
+constexpr std::array<float, PULSE_TABLE_SIZE> make_pulse_table() {
+    std::array<float, PULSE_TABLE_SIZE> table = {};
+    for (uint32_t n = 0; n < PULSE_TABLE_SIZE; n++) {
+        table[n] = (float)pulse_out(n);
+    }
+    return table;
+}
+
+// The TND output depends on each channel separately, so the table uses the
+// linear combination approximation from the nesdev wiki
+constexpr std::array<float, TND_TABLE_SIZE> make_tnd_table() {
+    std::array<float, TND_TABLE_SIZE> table = {};
+    for (uint32_t n = 1; n < TND_TABLE_SIZE; n++) {
+        table[n] = (float)(163.67 / (24329.0 / n + 100.0));
+    }
+    return table;
+}
+
+constexpr std::array<float, PULSE_TABLE_SIZE> PULSE_TABLE = make_pulse_table();
+constexpr std::array<float, TND_TABLE_SIZE> TND_TABLE = make_tnd_table();
+
+constexpr bool within_tolerance(const double a, const double b) {
+    return (a > b ? a - b : b - a) <= APURP2A03Mixer::MAX_TABLE_ERROR;
+}
+
+// Compare the TND table against the formula for every noise / DMC combination
+// at one triangle level
+constexpr bool tnd_table_within_tolerance(const uint32_t triangle) {
+    for (uint32_t noise = 0; noise < 16; noise++) {
+        for (uint32_t dmc = 0; dmc < 128; dmc++) {
+            if (!within_tolerance(TND_TABLE[3 * triangle + 2 * noise + dmc], tnd_out(triangle, noise, dmc))) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Each triangle level is its own constant evaluation, which keeps every one
+// well inside the compilers' constexpr step limits
+template <uint32_t... triangle>
+constexpr bool tnd_table_within_tolerance(std::integer_sequence<uint32_t, triangle...>) {
+    return (std::integral_constant<bool, tnd_table_within_tolerance(triangle)>::value && ...);
+}
+
+static_assert(tnd_table_within_tolerance(std::make_integer_sequence<uint32_t, 16>()), "TND table is outside of MAX_TABLE_ERROR from the formula");
+
+} // anonymous
+
+/**
+ * Mix whole blocks at a time.  There are no branches or loop carried
+ * dependencies so the compiler can vectorize the index math and the table
+ * gathers for whatever instruction set it targets.
+ */
+void APURP2A03Mixer::mix(
+    const uint8_t *pulse1,
+    const uint8_t *pulse2,
+    const uint8_t *triangle,
+    const uint8_t *noise,
+    const uint8_t *dmc,
+    float *samples,
+    const size_t count
+) {
+    const float *pulse_table = PULSE_TABLE.data();
+    const float *tnd_table = TND_TABLE.data();
+    for (size_t i = 0; i < count; i++) {
+        const uint32_t pulse_index = (uint32_t)pulse1[i] + pulse2[i];
+        const uint32_t tnd_index = 3 * (uint32_t)triangle[i] + 2 * (uint32_t)noise[i] + dmc[i];
+        samples[i] = pulse_table[pulse_index] + tnd_table[tnd_index];
+    }
+}
+
+}} // nes::apu
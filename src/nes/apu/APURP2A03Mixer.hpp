@@ -0,0 +1,59 @@
+/*******************************************************************************
+MIT License
+
+Copyright (c) 2020 Chris Luby
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+/*******************************************************************************
+Nonlinear mixer for the RP2A03 channels
+
+The mixer output is computed from two lookup tables generated at compile time,
+one indexed by pulse1 + pulse2 and one by 3 * triangle + 2 * noise + dmc.
+
+Links:
+- https://wiki.nesdev.com/w/index.php/APU_Mixer
+*******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace nes { namespace apu {
+
+class APURP2A03Mixer {
+public:
+    // Largest difference allowed between the lookup tables and the exact formulas
+    static constexpr double MAX_TABLE_ERROR = 0.015;
+
+    // Mix a block of channel outputs into samples using the lookup tables
+    static void mix(
+        const uint8_t *pulse1,
+        const uint8_t *pulse2,
+        const uint8_t *triangle,
+        const uint8_t *noise,
+        const uint8_t *dmc,
+        float *samples,
+        const size_t count
+    );
+};
+
+}} // nes::apu
@@ -26,8 +26,46 @@ SOFTWARE.
 APU emulation using SDL
 *******************************************************************************/
 
+#include <stdexcept>
+
+#include <SDL2/SDL.h>
+
+#include <utils/string_format.hpp>
 #include <nes/apu/APURP2A03SDL.hpp>
 
 namespace nes { namespace apu {
 
+APURP2A03SDL::APURP2A03SDL() {
+    SDL_AudioSpec want;
+    SDL_AudioSpec have;
+    SDL_memset(&want, 0, sizeof(want));
+    want.freq = SAMPLE_RATE;
+    want.format = AUDIO_F32SYS;
+    want.channels = 1;
+    want.samples = SAMPLE_BUFFER_SIZE;
+    want.callback = NULL; // Samples are pushed with SDL_QueueAudio
+
+    m_audio_device = SDL_OpenAudioDevice(NULL, 0, &want, &have, 0);
+    if (m_audio_device == 0) {
+        throw std::runtime_error(utils::string_format("Unable to open audio device: %s", SDL_GetError()));
+    }
+    SDL_PauseAudioDevice(m_audio_device, 0);
+}
+
+APURP2A03SDL::~APURP2A03SDL() {
+    if (m_audio_device != 0) {
+        SDL_CloseAudioDevice(m_audio_device);
+    }
+}
+
+void APURP2A03SDL::output_samples(const ChannelBlock &channels, const float *samples, const size_t count) {
+    // Drop samples rather than building up latency if emulation runs ahead
+    if (SDL_GetQueuedAudioSize(m_audio_device) / sizeof(float) < MAX_QUEUED_SAMPLES) {
+        SDL_QueueAudio(m_audio_device, samples, (uint32_t)(count * sizeof(float)));
+    }
+}
+
+void APURP2A03SDL::close_frame() {
+}
+
 }} // nes::apu
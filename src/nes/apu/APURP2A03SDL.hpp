@@ -28,16 +28,26 @@ APU emulation using SDL
 
 #pragma once
 
+#include <SDL2/SDL.h>
+
 #include <nes/apu/APURP2A03.hpp>
 
 namespace nes { namespace apu {
 
 class APURP2A03SDL : public APURP2A03 {
 public:
+    APURP2A03SDL();
+    ~APURP2A03SDL();
 
 protected:
+    void output_samples(const ChannelBlock &channels, const float *samples, const size_t count) override;
+    void close_frame() override;
 
 private:
+    // Don't let more than this many samples queue up in SDL
+    static const uint32_t MAX_QUEUED_SAMPLES = SAMPLE_RATE / 10;
+
+    SDL_AudioDeviceID m_audio_device;
 
 };
 
@@ -0,0 +1,187 @@
+/*******************************************************************************
+MIT License
+
+Copyright (c) 2020 Chris Luby
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+/*******************************************************************************
+Writes mono 32bit float WAV files from a background thread so the emulation
+thread only has to copy samples into a bounded queue
+
+Links:
+- http://soundfile.sapp.org/doc/WaveFormat/
+- http://www-mmsp.ece.mcgill.ca/Documents/AudioFormats/WAVE/WAVE.html
+*******************************************************************************/
+
+#include <stdexcept>
+#include <iostream>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <thread>
+#include <atomic>
+
+#include <utils/string_format.hpp>
+#include <nes/apu/WavWriter.hpp>
+
+namespace nes { namespace apu {
+
+namespace {
+
+void write_u16(std::ofstream &file, const uint16_t value) {
+    const uint8_t bytes[2] = { (uint8_t)(value & 0xFF), (uint8_t)(value >> 8) };
+    file.write((const char *)bytes, sizeof(bytes));
+}
+
+void write_u32(std::ofstream &file, const uint32_t value) {
+    const uint8_t bytes[4] = {
+        (uint8_t)(value & 0xFF), (uint8_t)((value >> 8) & 0xFF),
+        (uint8_t)((value >> 16) & 0xFF), (uint8_t)(value >> 24)
+    };
+    file.write((const char *)bytes, sizeof(bytes));
+}
+
+} // anonymous
+
+WavWriter::WavWriter(const std::string &filename, const uint32_t sample_rate)
+    : m_filename(filename)
+    , m_sample_rate(sample_rate)
+    , m_failed(false)
+    , m_full(false)
+    , m_queue(MAX_QUEUED_BLOCKS)
+    , m_free_blocks(MAX_QUEUED_BLOCKS) {
+    m_file.open(m_filename, std::ofstream::binary | std::ofstream::trunc);
+    if (!m_file.is_open()) {
+        throw std::runtime_error(utils::string_format("Failed to open WAV file %s", m_filename.c_str()));
+    }
+
+    // Sizes are patched in once the writer thread has finished
+    write_header();
+    if (!m_file) {
+        throw std::runtime_error(utils::string_format("Failed to write WAV file %s", m_filename.c_str()));
+    }
+
+    // Every block there can be, each one grows to fit on first use
+    for (size_t i = 0; i < MAX_QUEUED_BLOCKS; i++) {
+        m_free_blocks.push(std::vector<float>());
+    }
+
+    m_thread = std::thread(&WavWriter::run, this);
+}
+
+WavWriter::~WavWriter() {
+    m_queue.close();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+
+    if (!m_failed) {
+        m_file.seekp(0);
+        write_header();
+        m_file.close();
+    }
+    if (m_failed || m_file.fail()) {
+        std::cerr << utils::string_format("Failed to write WAV file %s, it is incomplete", m_filename.c_str()) << std::endl;
+    } else if (m_full) {
+        std::cerr << utils::string_format("WAV file %s reached the 4GB limit, later samples were dropped", m_filename.c_str()) << std::endl;
+    }
+}
+
+void WavWriter::write(const float *samples, const size_t count) {
+    if (m_failed) {
+        throw std::runtime_error(utils::string_format("Failed to write WAV file %s", m_filename.c_str()));
+    }
+    if (m_full) {
+        throw std::runtime_error(utils::string_format("WAV file %s reached the 4GB limit", m_filename.c_str()));
+    }
+
+    // A free block is always coming, the writer hands one back per block written
+    std::vector<float> block;
+    m_free_blocks.pop(block);
+    block.assign(samples, samples + count);
+    m_queue.push(std::move(block));
+}
+
+void WavWriter::run() {
+    std::vector<float> block;
+    std::vector<uint8_t> bytes;
+    while (m_queue.pop(block)) {
+        // Keep draining after a failure so write() never waits on a free block
+        if (m_failed || m_full) {
+            m_free_blocks.push(std::move(block));
+            continue;
+        }
+
+        // The sizes in the header are 32 bits, keep what fits and stop there
+        size_t count = block.size();
+        if ((uint64_t)m_data_size + count * sizeof(float) > MAX_DATA_SIZE) {
+            count = (MAX_DATA_SIZE - m_data_size) / sizeof(float);
+            m_full = true;
+        }
+
+        // Always write little endian regardless of the host
+        bytes.resize(count * sizeof(float));
+        for (size_t i = 0; i < count; i++) {
+            uint32_t bits;
+            memcpy(&bits, &block[i], sizeof(bits));
+            bytes[i * 4 + 0] = (uint8_t)(bits & 0xFF);
+            bytes[i * 4 + 1] = (uint8_t)((bits >> 8) & 0xFF);
+            bytes[i * 4 + 2] = (uint8_t)((bits >> 16) & 0xFF);
+            bytes[i * 4 + 3] = (uint8_t)(bits >> 24);
+        }
+        m_file.write((const char *)bytes.data(), bytes.size());
+        m_data_size += (uint32_t)bytes.size();
+        if (!m_file) {
+            m_failed = true;
+        }
+        m_free_blocks.push(std::move(block));
+    }
+}
+
+/**
+ * Formats other than PCM need the extended fmt chunk and a fact chunk
+ */
+void WavWriter::write_header() {
+    m_file.write("RIFF", 4);
+    write_u32(m_file, RIFF_HEADER_SIZE + m_data_size);
+    m_file.write("WAVE", 4);
+
+    m_file.write("fmt ", 4);
+    write_u32(m_file, 18);
+    write_u16(m_file, FORMAT_IEEE_FLOAT);
+    write_u16(m_file, NUM_CHANNELS);
+    write_u32(m_file, m_sample_rate);
+    write_u32(m_file, m_sample_rate * BLOCK_ALIGN);
+    write_u16(m_file, BLOCK_ALIGN);
+    write_u16(m_file, BITS_PER_SAMPLE);
+    write_u16(m_file, 0); // No extension
+
+    m_file.write("fact", 4);
+    write_u32(m_file, 4);
+    write_u32(m_file, m_data_size / BLOCK_ALIGN); // Sample frames
+
+    m_file.write("data", 4);
+    write_u32(m_file, m_data_size);
+}
+
+}} // nes::apu
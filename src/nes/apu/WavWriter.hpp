@@ -0,0 +1,86 @@
+/*******************************************************************************
+MIT License
+
+Copyright (c) 2020 Chris Luby
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+/*******************************************************************************
+Writes mono 32bit float WAV files from a background thread so the emulation
+thread only has to copy samples into a bounded queue.  Sample blocks go back to
+a free list once written, so after the first few nothing is allocated.
+
+Links:
+- http://soundfile.sapp.org/doc/WaveFormat/
+- http://www-mmsp.ece.mcgill.ca/Documents/AudioFormats/WAVE/WAVE.html
+*******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <thread>
+#include <atomic>
+
+#include <utils/BoundedQueue.hpp>
+
+namespace nes { namespace apu {
+
+class WavWriter {
+public:
+    WavWriter(const std::string &filename, const uint32_t sample_rate);
+    // Finishes the file, reporting to stderr if it couldn't be written in full
+    ~WavWriter();
+
+    // Queue samples to be written, blocks if the writer has fallen behind.
+    // Throws std::runtime_error once writing to the file has failed or the
+    // file has reached the 4GB WAV limit.
+    void write(const float *samples, const size_t count);
+
+private:
+    static const size_t MAX_QUEUED_BLOCKS = 64;
+    static const uint16_t FORMAT_IEEE_FLOAT = 3;
+    static const uint16_t NUM_CHANNELS = 1;
+    static const uint16_t BITS_PER_SAMPLE = 32;
+    static const uint16_t BLOCK_ALIGN = NUM_CHANNELS * BITS_PER_SAMPLE / 8;
+    // RIFF size without the samples: "WAVE", the fmt and fact chunks and the data chunk header
+    static const uint32_t RIFF_HEADER_SIZE = 4 + (8 + 18) + (8 + 4) + 8;
+    // Largest data chunk that keeps the RIFF size in 32 bits
+    static const uint32_t MAX_DATA_SIZE = (UINT32_MAX - RIFF_HEADER_SIZE) / BLOCK_ALIGN * BLOCK_ALIGN;
+
+    std::string m_filename;
+    uint32_t m_sample_rate;
+    std::ofstream m_file;
+    uint32_t m_data_size = 0;
+    std::atomic<bool> m_failed;
+    std::atomic<bool> m_full; // Samples past MAX_DATA_SIZE were dropped
+
+    utils::BoundedQueue<std::vector<float>> m_queue;
+    utils::BoundedQueue<std::vector<float>> m_free_blocks;
+    std::thread m_thread;
+
+    void run();
+    void write_header();
+};
+
+}} // nes::apu
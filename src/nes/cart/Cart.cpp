@@ -27,79 +27,85 @@ Emulation of the Nintendo Entertainment System Cartridge
 
 Links:
 - https://wiki.nesdev.com/w/index.php/INES
+- https://wiki.nesdev.com/w/index.php/NES_2.0
 *******************************************************************************/
 
 #include <stdexcept>
 #include <iostream>
-#include <fstream>
 #include <cstdint>
 #include <cstring>
+#include <algorithm>
 
 #include <utils/string_format.hpp>
+#include <utils/crc32.hpp>
 #include <nes/cart/Cart.hpp>
-#include <nes/cart/mapper/Mapper000.hpp>
-#include <nes/cart/mapper/Mapper999.hpp>
+#include <nes/cart/RomImage.hpp>
+#include <nes/cart/RomCache.hpp>
+#include <nes/cart/mapper/MapperRegistry.hpp>
 #include <nes/cpu/CPU2A03.hpp>
 
 namespace nes { namespace cart {
 
 //const char Cart::MAGIC[4] = {0x4E, 0x45, 0x53, 0x1A}; // NES followed by MS-DOS EOF
 
-Cart::Cart(const std::string &filename) {
+Cart::Cart(const std::string &filename, const bool memory_map, std::shared_ptr<const RomDatabase> database, const bool save_battery) {
     // WARNING: This is a shared pointer hack to allow us to use shared_from_this()
     // from within the constructor so we can hand a shared pointer to the mapper.
     const auto trickDontRemove = std::shared_ptr<Cart>(this, [](Cart *){});
 
     m_filename = filename;
+    m_rom = RomCache::instance().load(m_filename, memory_map);
 
-    std::ifstream ifs;
-	ifs.open(m_filename, std::ifstream::binary);
-	if (ifs.is_open()) {
-		// Read header
-		ifs.read((char *)&m_header, sizeof(Header));
-
-        // Validate header
-        if (strncmp(m_header.ines1.magic, MAGIC, 4) != 0) {
-            throw std::runtime_error(utils::string_format("Cart magic is wrong.  Got %02X %02X %02X %02X but expected %02X %02X %02X %02X",
-                m_header.ines1.magic[0], m_header.ines1.magic[1], m_header.ines1.magic[2], m_header.ines1.magic[3],
-                MAGIC[0], MAGIC[1], MAGIC[2], MAGIC[0]
-            ));
-        }
+    // Read header
+    if (m_rom->size() < sizeof(Header)) {
+        throw std::runtime_error(utils::string_format("ROM %s is too small to hold a header", m_filename.c_str()));
+    }
+    memcpy(&m_header, m_rom->data(), sizeof(Header));
+    uint64_t offset = sizeof(Header);
+
+    // Validate header
+    if (strncmp(m_header.ines1.magic, MAGIC, 4) != 0) {
+        throw std::runtime_error(utils::string_format("Cart magic is wrong.  Got %02X %02X %02X %02X but expected %02X %02X %02X %02X",
+            m_header.ines1.magic[0], m_header.ines1.magic[1], m_header.ines1.magic[2], m_header.ines1.magic[3],
+            MAGIC[0], MAGIC[1], MAGIC[2], MAGIC[0]
+        ));
+    }
 
-        // Check for iNES2 style header
-        if (m_header.ines1.flags7.ines2 == 2) {
-            // Handle as iNES2
-            throw std::runtime_error("iNES2 not supported");
-        } else {
-            // Handle as iNES1
-            m_mapper_id = m_header.ines1.flags7.mapper_id_high << 4 | m_header.ines1.flags6.mapper_id_low;
-
-            // Skip trainer if present
-            if (m_header.ines1.flags6.contains_trainer) {
-                ifs.seekg(512, std::ios_base::cur);
-            }
+    // Check for iNES2 style header
+    uint32_t prg_ram_size = 0;
+    uint32_t chr_ram_size = 0;
+    if (m_header.ines1.flags7.ines2 == INES2_ID) {
+        parse_ines2(prg_ram_size, chr_ram_size);
+    } else {
+        parse_ines1(prg_ram_size, chr_ram_size);
+    }
 
-            // Read the PRG image
-            m_num_prg_banks = m_header.ines1.num_prg_banks;
-            m_prg_mem.resize(m_num_prg_banks * PRG_BANK_SIZE);
-            ifs.read((char*)m_prg_mem.data(), m_prg_mem.size());
-
-            // Read the CHR image
-            m_num_chr_banks = m_header.ines1.num_chr_banks;
-            if (m_num_chr_banks == 0) {
-                // Using RAM for CHR
-                m_chr_mem.resize(CHR_BANK_SIZE);
-            } else {
-                // Using ROM for CHR
-                m_chr_mem.resize(m_num_prg_banks * CHR_BANK_SIZE);
-            }
-            ifs.read((char*)m_chr_mem.data(), m_chr_mem.size());
-        }
+    // Skip trainer if present
+    if (m_header.ines1.flags6.contains_trainer) {
+        offset += TRAINER_SIZE;
+    }
 
-        setup_mapper();
-    } else {
-        throw std::runtime_error(utils::string_format("Failed to load ROM %s", m_filename.c_str()));
+    // PRG image
+    m_prg_rom = m_rom->data() + offset;
+    offset += m_prg_rom_size;
+
+    // CHR image
+    m_chr_rom = m_rom->data() + offset;
+    offset += m_chr_rom_size;
+
+    if (offset > m_rom->size()) {
+        throw std::runtime_error(utils::string_format("ROM %s is truncated.  Expected %llu bytes but got %llu", m_filename.c_str(), (unsigned long long)offset, (unsigned long long)m_rom->size()));
     }
+
+    // Headers in the wild are often wrong, trust the database when it knows the ROM
+    m_crc32 = utils::crc32(m_chr_rom, m_chr_rom_size, utils::crc32(m_prg_rom, m_prg_rom_size));
+    m_database_match = false;
+    if (database != nullptr) {
+        apply_database(*database, prg_ram_size, chr_ram_size);
+    }
+
+    setup_ram(prg_ram_size, chr_ram_size, save_battery);
+    setup_mapper();
 }
 
 Cart::Cart(const std::vector<uint8_t> &rom_memory) {
@@ -111,97 +117,241 @@ Cart::Cart(const std::vector<uint8_t> &rom_memory) {
 
     memset(&m_header, 0, sizeof(Header));
 
-    m_num_prg_banks = rom_memory.size() / PRG_BANK_SIZE;
-    m_prg_mem = rom_memory;
+    // Load the code at the start of PRG and point the reset vector at it
+    std::vector<uint8_t> prg(rom_memory);
+    prg.resize(2 * PRG_BANK_SIZE);
+    prg[nes::cpu::CPU2A03::RESET_PC_ADDR & 0x7FFF] = 0x00;
+    prg[(nes::cpu::CPU2A03::RESET_PC_ADDR + 1) & 0x7FFF] = 0x80;
+    m_rom = RomCache::instance().insert(std::move(prg));
+
+    m_num_prg_banks = m_rom->size() / PRG_BANK_SIZE;
+    m_prg_rom = m_rom->data();
+    m_prg_rom_size = m_rom->size();
+    m_num_chr_banks = 0;
+    m_chr_rom = nullptr;
+    m_chr_rom_size = 0;
     m_mapper_id = 999;
-
+    m_sub_mapper_id = 0;
+    m_timing_type = NTSC;
+    m_mirroring = MIRROR_HORIZONTAL;
+    m_crc32 = utils::crc32(m_prg_rom, m_prg_rom_size);
+    m_database_match = false;
+    m_prg_nvram_size = 0;
+    m_chr_nvram_size = 0;
+
+    setup_ram(0, CHR_BANK_SIZE, false);
     setup_mapper();
+}
 
-    // Expand the rom size to have space to write the start address
-    m_prg_mem.resize(0xFFFF);
-    cpu_write(nes::cpu::CPU2A03::RESET_PC_ADDR, 0x00);
-    cpu_write(nes::cpu::CPU2A03::RESET_PC_ADDR + 1, 0x80);
+Cart::Cart(const Cart &cart)
+    : Component(cart)
+    , std::enable_shared_from_this<Cart>()
+    , m_filename(cart.m_filename)
+    , m_header(cart.m_header)
+    , m_rom(cart.m_rom)
+    , m_num_prg_banks(cart.m_num_prg_banks)
+    , m_prg_rom(cart.m_prg_rom)
+    , m_prg_rom_size(cart.m_prg_rom_size)
+    , m_num_chr_banks(cart.m_num_chr_banks)
+    , m_chr_rom(cart.m_chr_rom)
+    , m_chr_rom_size(cart.m_chr_rom_size)
+    , m_prg_ram_memory(cart.m_prg_ram_memory)
+    , m_prg_ram_size(cart.m_prg_ram_size)
+    , m_prg_nvram_size(cart.m_prg_nvram_size)
+    , m_chr_ram(cart.m_chr_ram)
+    , m_chr_ram_size(cart.m_chr_ram_size)
+    , m_chr_nvram_size(cart.m_chr_nvram_size)
+    , m_mapper_id(cart.m_mapper_id)
+    , m_sub_mapper_id(cart.m_sub_mapper_id)
+    , m_timing_type(cart.m_timing_type)
+    , m_mirroring(cart.m_mirroring)
+    , m_crc32(cart.m_crc32)
+    , m_database_match(cart.m_database_match) {
+    // Only the original writes the save file
+    if (cart.prg_ram_in_save_file()) {
+        m_prg_ram_memory.assign(cart.m_save_file->data(), m_prg_ram_size);
+    }
 }
 
 Cart::~Cart() {
+    // The save file syncs whatever it holds as it closes
+    if (m_save_file != nullptr) {
+        store_prg_nvram();
+    }
 }
 
-void Cart::setup_mapper() {
-    // Setup the mapper
-    switch (m_mapper_id) {
-        case 0: m_mapper = std::make_shared<nes::cart::mapper::Mapper000>(shared_from_this(), m_num_prg_banks, m_num_chr_banks); break;
-        case 999: m_mapper = std::make_shared<nes::cart::mapper::Mapper999>(shared_from_this(), m_num_prg_banks, m_num_chr_banks); break;
-        default: throw std::runtime_error(utils::string_format("Mapper %u not supported", m_mapper_id));
-    }
+std::shared_ptr<Cart> Cart::fork() {
+    std::shared_ptr<Cart> cart(new Cart(*this));
+    cart->m_mapper = m_mapper->clone(cart);
+
+    // RAM is shared now, so both sides republish with its writes deferred
+    cart->m_mapper->update_banks();
+    m_mapper->update_banks();
+    return cart;
 }
 
-void Cart::reset() {
-    // Reset the mapper but do not reload the cartridge
-    if (m_mapper != nullptr) {
-        m_mapper->reset();
-    }
+void Cart::unshare_prg_ram() {
+    m_prg_ram_memory.writable_data();
+    m_mapper->update_banks();
+}
+
+void Cart::unshare_chr_ram() {
+    m_chr_ram.writable_data();
+    m_mapper->update_banks();
 }
 
-const bool Cart::cpu_read(const uint16_t addr, uint8_t &data, const bool read_only) {
-    data = 0x00;
+void Cart::setup_mapper() {
+    // Setup the mapper from whichever mappers were linked in
+    m_mapper = nes::cart::mapper::MapperRegistry::instance().create(m_mapper_id, m_sub_mapper_id, shared_from_this(), m_num_prg_banks, m_num_chr_banks);
+
+    // Publish the banks before anything reads from the cart
+    m_mapper->reset();
+}
+
+/**
+ * iNES1 only counts 16KB PRG and 8KB CHR banks and has to guess at RAM
+ */
+void Cart::parse_ines1(uint32_t &prg_ram_size, uint32_t &chr_ram_size) {
+    m_mapper_id = m_header.ines1.flags7.mapper_id_high << 4 | m_header.ines1.flags6.mapper_id_low;
+    m_sub_mapper_id = 0;
+    m_timing_type = m_header.ines1.flags9.tv_system_pal ? PAL : NTSC;
+    m_mirroring = m_header.ines1.flags6.ignore_mirroring ? MIRROR_FOUR_SCREEN : (m_header.ines1.flags6.mirror_vertical ? MIRROR_VERTICAL : MIRROR_HORIZONTAL);
+
+    m_num_prg_banks = m_header.ines1.num_prg_banks;
+    m_prg_rom_size = m_num_prg_banks * PRG_BANK_SIZE;
+    m_num_chr_banks = m_header.ines1.num_chr_banks;
+    m_chr_rom_size = m_num_chr_banks * CHR_BANK_SIZE;
+
+    // A PRG-RAM count of 0 means one bank for compatibility, and carts without
+    // CHR-ROM have 8KB of CHR-RAM
+    prg_ram_size = std::max<uint32_t>(m_header.ines1.num_prg_ram_banks, 1) * PRG_RAM_BANK_SIZE;
+    chr_ram_size = m_chr_rom_size == 0 ? CHR_BANK_SIZE : 0;
+    m_prg_nvram_size = m_header.ines1.flags6.contains_battery_backed_ram ? prg_ram_size : 0;
+    m_chr_nvram_size = 0;
+}
 
-    uint32_t mapped_addr = 0x00000000L;
-    if (m_mapper->cpu_map_read_addr(addr, mapped_addr)) {
-        std::cout << utils::string_format("R: $%04X -> $%04X", addr, mapped_addr) << std::endl;
-        if (mapped_addr < m_prg_mem.size()) {
-            data = m_prg_mem[mapped_addr];
-            return true;
-        } else {
-            throw std::runtime_error(utils::string_format("Mapped read address 0x%08X is out of PRG range 0x%08X - 0x%08X", mapped_addr, 0, m_prg_mem.size()));
+/**
+ * iNES2 gives exact ROM and RAM sizes
+ */
+void Cart::parse_ines2(uint32_t &prg_ram_size, uint32_t &chr_ram_size) {
+    const auto &header = m_header.ines2;
+
+    m_mapper_id = header.mapper.mapper_id_extended << 8 | header.flags7.mapper_id_high << 4 | header.flags6.mapper_id_low;
+    m_sub_mapper_id = header.mapper.sub_mapper_id;
+    m_timing_type = (TimingType)header.timing.timing_type;
+    m_mirroring = header.flags6.ignore_mirroring ? MIRROR_FOUR_SCREEN : (header.flags6.mirror_vertical ? MIRROR_VERTICAL : MIRROR_HORIZONTAL);
+
+    // Either a 12bit bank count or 2^E * (M * 2 + 1) bytes
+    auto rom_size = [](const uint8_t low, const uint8_t high, const uint32_t bank_size) -> uint32_t {
+        if (high == INES2_ROM_SIZE_EXPONENT) {
+            const uint8_t exponent = low >> 2;
+            const uint8_t multiplier = (low & 0x03) * 2 + 1;
+            if (exponent >= 32 || ((uint64_t)multiplier << exponent) > UINT32_MAX) {
+                throw std::runtime_error(utils::string_format("ROM size 2^%u * %u is too large", exponent, multiplier));
+            }
+            return (uint32_t)multiplier << exponent;
         }
+        return (high << 8 | low) * bank_size;
+    };
+    m_prg_rom_size = rom_size(header.num_prg_banks_low, header.rom.num_prg_banks_high, PRG_BANK_SIZE);
+    m_num_prg_banks = (m_prg_rom_size + PRG_BANK_SIZE - 1) / PRG_BANK_SIZE;
+    m_chr_rom_size = rom_size(header.num_chr_banks_low, header.rom.num_chr_banks_high, CHR_BANK_SIZE);
+    m_num_chr_banks = (m_chr_rom_size + CHR_BANK_SIZE - 1) / CHR_BANK_SIZE;
+
+    // Shift counts are 64 << count bytes, with 0 meaning none
+    auto ram_size = [](const uint8_t shift_count) -> uint32_t {
+        return shift_count > 0 ? 64 << shift_count : 0;
+    };
+    m_prg_nvram_size = ram_size(header.prg_ram.prg_nvram_shift_count);
+    prg_ram_size = ram_size(header.prg_ram.prg_ram_shift_count) + m_prg_nvram_size;
+    m_chr_nvram_size = ram_size(header.chr_ram.chr_nvram_shift_count);
+    chr_ram_size = ram_size(header.chr_ram.chr_ram_shift_count) + m_chr_nvram_size;
+}
+
+void Cart::apply_database(const RomDatabase &database, uint32_t &prg_ram_size, uint32_t &chr_ram_size) {
+    RomDatabase::Record record;
+    if (!database.find(m_crc32, record)) {
+        return;
     }
 
-    return false;
+    m_database_match = true;
+    m_mapper_id = record.mapper_id;
+    m_sub_mapper_id = record.sub_mapper_id;
+    m_mirroring = (Mirroring)record.mirroring;
+    m_timing_type = (TimingType)record.timing_type;
+    m_prg_nvram_size = record.prg_nvram_size;
+    prg_ram_size = record.prg_ram_size + record.prg_nvram_size;
+    m_chr_nvram_size = record.chr_nvram_size;
+    chr_ram_size = record.chr_ram_size + record.chr_nvram_size;
 }
 
-const bool Cart::cpu_write(const uint16_t addr, const uint8_t data) {
-    uint32_t mapped_addr = 0x00000000L;
-    if (m_mapper->cpu_map_write_addr(addr, mapped_addr, data)) {
-        // std::cout << utils::string_format("W: $%04X -> $%04X", addr, mapped_addr) << std::endl;
-        if (mapped_addr < m_prg_mem.size()) {
-            m_prg_mem[mapped_addr] = data;
-            return true;
-        } else {
-            throw std::runtime_error(utils::string_format("Mapped write address 0x%08X is out of PRG range 0x%08X - 0x%08X", mapped_addr, 0, m_prg_mem.size()));
+/**
+ * PRG-RAM is exactly the size of the chips, the mapper mirrors anything smaller
+ * than a window across it.  CHR-RAM backing memory is rounded up to whole
+ * mapper windows so a bank pointer never runs off the end.
+ */
+void Cart::setup_ram(const uint32_t prg_ram_size, const uint32_t chr_ram_size, const bool save_battery) {
+    m_prg_ram_size = prg_ram_size;
+    if (save_battery && m_prg_nvram_size > 0 && m_prg_ram_size > 0) {
+        m_save_file = std::make_unique<SaveFile>(SaveFile::filename_for(m_filename), std::min(m_prg_nvram_size, m_prg_ram_size));
+    }
+    if (!prg_ram_in_save_file()) {
+        m_prg_ram_memory.assign(m_prg_ram_size, 0x00);
+        if (m_save_file != nullptr) {
+            memcpy(m_prg_ram_memory.writable_data() + m_prg_ram_size - m_save_file->size(), m_save_file->data(), m_save_file->size());
         }
     }
+    m_chr_ram_size = chr_ram_size;
+    m_chr_ram.assign(round_up(chr_ram_size, mapper::Mapper::CHR_WINDOW_SIZE), 0x00);
+}
 
-    return false;
+void Cart::store_prg_nvram() {
+    if (!prg_ram_in_save_file()) {
+        memcpy(m_save_file->data(), m_prg_ram_memory.data() + m_prg_ram_size - m_save_file->size(), m_save_file->size());
+    }
+}
+
+void Cart::reset() {
+    // Reset the mapper but do not reload the cartridge
+    if (m_mapper != nullptr) {
+        m_mapper->reset();
+    }
 }
 
-const bool Cart::ppu_read(const uint16_t addr, uint8_t &data, const bool read_only) {
-    data = 0x00;
+const bool Cart::cpu_write(const uint16_t addr, const uint8_t data) {
+    uint8_t *bank = m_mapper->prg_write_bank(addr);
+    if (bank == nullptr && m_mapper->prg_write_deferred(addr)) {
+        unshare_prg_ram();
+        bank = m_mapper->prg_write_bank(addr);
+    }
+    if (bank != nullptr) {
+        bank[addr & m_mapper->prg_mask(addr)] = data;
+        return true;
+    }
 
-    uint32_t mapped_addr = 0x00000000L;
-    if (m_mapper->ppu_map_read_addr(addr, mapped_addr)) {
-        if (mapped_addr < m_chr_mem.size()) {
-            data = m_chr_mem[mapped_addr];
-            return true;
-        } else {
-            throw std::runtime_error(utils::string_format("Mapped read address 0x%08X is out of CHR range 0x%08X - 0x%08X", mapped_addr, 0, m_chr_mem.size()));
-        }
+    // Anything else in cartridge space is for the mapper registers
+    if (addr >= ADDR_MAPPER_BEGIN) {
+        return m_mapper->cpu_write(addr, data);
     }
 
     return false;
 }
 
-const bool Cart::ppu_write(const uint16_t addr, const uint8_t data) {
-    uint32_t mapped_addr = 0x00000000L;
-    if (m_mapper->ppu_map_write_addr(addr, mapped_addr, data)) {
-        if (mapped_addr < m_chr_mem.size()) {
-            m_chr_mem[mapped_addr] = data;
-            return true;
-        } else {
-            throw std::runtime_error(utils::string_format("Mapped write address 0x%08X is out of CHR range 0x%08X - 0x%08X", mapped_addr, 0, m_chr_mem.size()));
-        }
-    }
+void Cart::save_state(StateWriter &state) const {
+    state.begin("CART");
+    Component::save_state(state);
+    state.write(prg_ram(), m_prg_ram_size);
+    state.write(m_chr_ram.data(), m_chr_ram.size());
+    m_mapper->save_state(state);
+}
 
-    return false;
+void Cart::load_state(StateReader &state) {
+    state.begin("CART");
+    Component::load_state(state);
+    state.read(prg_ram_in_save_file() ? m_save_file->data() : m_prg_ram_memory.writable_data(), m_prg_ram_size);
+    state.read(m_chr_ram.writable_data(), m_chr_ram.size());
+    m_mapper->load_state(state);
+    m_mapper->update_banks();
 }
 
 std::ostream& operator<<(std::ostream& os, const Cart& cart) {
@@ -210,13 +360,24 @@ std::ostream& operator<<(std::ostream& os, const Cart& cart) {
         "%02X %02X %02X %02X = %c%c%c",
         cart.m_header.ines1.magic[0], cart.m_header.ines1.magic[1], cart.m_header.ines1.magic[2], cart.m_header.ines1.magic[3],
         cart.m_header.ines1.magic[0], cart.m_header.ines1.magic[1], cart.m_header.ines1.magic[2]
-    ) << ", Type: " << (cart.m_header.ines1.flags7.ines2 == 2 ? 2 : 1) << std::endl;
-    os << "  Mapper " << cart.m_mapper_id << std::endl;
-    if (cart.m_header.ines1.flags7.ines2 == 2) {
-        // Display as iNES2
-    } else {
-        // Display as iNES1
+    ) << ", Type: " << (cart.m_header.ines1.flags7.ines2 == INES2_ID ? 2 : 1) << std::endl;
+    os << utils::string_format("  CRC-32: %08X", cart.m_crc32) << (cart.m_database_match ? " (found in database)" : "") << std::endl;
+    os << "  Mapper " << cart.m_mapper_id << "." << (uint32_t)cart.m_sub_mapper_id << std::endl;
+    os << utils::string_format(
+        "  PRG-ROM: %uKB, CHR-ROM: %uKB",
+        cart.m_prg_rom_size / 1024, cart.m_chr_rom_size / 1024
+    ) << std::endl;
+    os << utils::string_format(
+        "  PRG-RAM: %uB (%uB battery), CHR-RAM: %uB (%uB battery)",
+        cart.m_prg_ram_size, cart.m_prg_nvram_size, cart.m_chr_ram_size, cart.m_chr_nvram_size
+    ) << std::endl;
+    if (cart.m_save_file != nullptr) {
+        os << "  Save: " << cart.m_save_file->filename() << std::endl;
     }
+    const char *timing_names[] = { "NTSC", "PAL", "Multi-region", "Dendy" };
+    const char *mirroring_names[] = { "Horizontal", "Vertical", "Four screen", "Single screen low", "Single screen high" };
+    os << "  Mirroring: " << mirroring_names[std::min<uint32_t>(cart.m_mirroring, MIRROR_SINGLE_SCREEN_HIGH)] << std::endl;
+    os << "  Timing: " << timing_names[cart.m_timing_type & 0x03] << std::endl;
     return os;
 }
 
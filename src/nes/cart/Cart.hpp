@@ -27,6 +27,7 @@ Emulation of the Nintendo Entertainment System Cartridge
 
 Links:
 - https://wiki.nesdev.com/w/index.php/INES
+- https://wiki.nesdev.com/w/index.php/NES_2.0
 *******************************************************************************/
 
 #pragma once
@@ -38,62 +39,217 @@ Links:
 #include <memory>
 
 #include <nes/Component.hpp>
+#include <nes/CowBuffer.hpp>
+#include <nes/Scheduler.hpp>
 #include <nes/cart/Header.hpp>
+#include <nes/cart/RomImage.hpp>
+#include <nes/cart/RomDatabase.hpp>
+#include <nes/cart/SaveFile.hpp>
 #include <nes/cart/mapper/Mapper.hpp>
-#include <nes/cart/mapper/Mapper999.hpp>
 
 namespace nes { namespace cart {
 
-class Cart : public Component, public std::enable_shared_from_this<Cart> {
+class Cart final : public Component, public std::enable_shared_from_this<Cart> {
 public:
     static const uint32_t PRG_BANK_SIZE = 16 * 1024;
     static const uint32_t CHR_BANK_SIZE = 8 * 1024;
-
-    Cart(const std::string &filename);
+    static const uint32_t TRAINER_SIZE = 512;
+    static const uint32_t PRG_RAM_BANK_SIZE = 8 * 1024;
+
+    // Memory mapping shares the ROM pages with every other cart using the file.
+    // Known ROMs found in the database override what the header says.  Without
+    // save_battery, battery backed RAM starts empty and is never written out
+    // (test runs that have to repeat exactly).
+    Cart(const std::string &filename, const bool memory_map = false, std::shared_ptr<const RomDatabase> database = nullptr, const bool save_battery = true);
     Cart(const std::vector<uint8_t> &rom_memory);
     ~Cart();
 
     // Setup the mapper once the ID is known
     void setup_mapper();
 
+    // Copy of the cart sharing ROM and, until either side writes to it, RAM.
+    // Battery backed RAM stays in the save file and the copy gets its own.
+    std::shared_ptr<Cart> fork();
+
     // Reset cartridge to a known state (mainly the mapper)
     void reset() override;
 
+    // RAM and mapper registers, ROM is never saved
+    void save_state(StateWriter &state) const override;
+    void load_state(StateReader &state) override;
+
+    // Mappers that care about timing read the current CPU cycle from here
+    void connect_scheduler(std::shared_ptr<nes::Scheduler> scheduler) {
+        m_mapper->connect_scheduler(scheduler);
+    }
+
+    // State of the IRQ line driven by the mapper
+    const bool irq() const {
+        return m_mapper->irq();
+    }
+
+    // Scanline counter driven by the bus, see Mapper
+    const bool scanline_counter() const {
+        return m_mapper->scanline_counter();
+    }
+    void clock_scanline_counter(const uint32_t count) {
+        m_mapper->clock_scanline_counter(count);
+    }
+    const uint32_t scanline_clocks_until_irq() const {
+        return m_mapper->scanline_clocks_until_irq();
+    }
+
+    // Battery backed RAM goes to disk in the background at the end of each
+    // frame, sync waits for it (on exit)
+    void flush_battery_ram() {
+        if (m_save_file != nullptr) {
+            store_prg_nvram();
+            m_save_file->flush();
+        }
+    }
+    void sync_battery_ram() {
+        if (m_save_file != nullptr) {
+            store_prg_nvram();
+            m_save_file->sync();
+        }
+    }
+
     // Handle read/write from CPU bus
-    const bool cpu_read(const uint16_t addr, uint8_t &data, const bool read_only = false) override;
+    const bool cpu_read(const uint16_t addr, uint8_t &data, const bool read_only = false) override {
+        const uint8_t *bank = m_mapper->prg_read_bank(addr);
+        if (bank != nullptr) {
+            data = bank[addr & m_mapper->prg_mask(addr)];
+            return true;
+        }
+        data = 0x00;
+        return false;
+    }
     const bool cpu_write(const uint16_t addr, const uint8_t data) override;
 
+    // Direct access to the 256 byte CPU page holding addr, nullptr if the cart
+    // doesn't respond there or mirrors something smaller than a page
+    const uint8_t *cpu_page(const uint16_t addr) const {
+        const uint8_t *bank = m_mapper->prg_read_bank(addr);
+        const uint16_t mask = m_mapper->prg_mask(addr);
+        return bank != nullptr && mask >= 0x00FF ? bank + (addr & mask & 0xFF00) : nullptr;
+    }
+
+    // Console region the cart was made for
+    const TimingType timing_type() const {
+        return m_timing_type;
+    }
+
+    // Nametable mirroring wired on the board
+    const Mirroring mirroring() const {
+        return m_mirroring;
+    }
+
+    // CRC-32 of PRG+CHR-ROM
+    const uint32_t crc32() const {
+        return m_crc32;
+    }
+
     // Handle read/write from PPU bus
-    const bool ppu_read(const uint16_t addr, uint8_t &data, const bool read_only = false);
-    const bool ppu_write(const uint16_t addr, const uint8_t data);
+    const bool ppu_read(const uint16_t addr, uint8_t &data, const bool read_only = false) {
+        if (addr <= ADDR_CHR_END) {
+            const uint8_t *bank = m_mapper->chr_read_bank(addr);
+            if (bank != nullptr) {
+                data = bank[addr & mapper::Mapper::CHR_WINDOW_MASK];
+                return true;
+            }
+        }
+        data = 0x00;
+        return false;
+    }
+    const bool ppu_write(const uint16_t addr, const uint8_t data) {
+        if (addr <= ADDR_CHR_END) {
+            uint8_t *bank = m_mapper->chr_write_bank(addr);
+            if (bank == nullptr && m_mapper->chr_write_deferred(addr)) {
+                unshare_chr_ram();
+                bank = m_mapper->chr_write_bank(addr);
+            }
+            if (bank != nullptr) {
+                bank[addr & mapper::Mapper::CHR_WINDOW_MASK] = data;
+                return true;
+            }
+        }
+        return false;
+    }
 
     friend std::ostream& operator<<(std::ostream& os, const Cart& cart);
 
+    // Mappers point their banks straight into the cart memory
+    friend class nes::cart::mapper::Mapper;
+
 private:
     std::string m_filename;
     Header m_header;
 
-    uint8_t m_num_prg_banks;
-    std::vector<uint8_t> m_prg_mem;
-    uint8_t m_num_chr_banks;
-    std::vector<uint8_t> m_chr_mem;
+    // PRG and CHR ROM are views into the ROM image, shared with every other
+    // cart running the same ROM
+    std::shared_ptr<const RomImage> m_rom;
+    uint16_t m_num_prg_banks;
+    const uint8_t *m_prg_rom;
+    uint32_t m_prg_rom_size;
+    uint16_t m_num_chr_banks;
+    const uint8_t *m_chr_rom;
+    uint32_t m_chr_rom_size;
+
+    // Volatile RAM followed by battery backed RAM, exactly as big as the chips.
+    // The save file only holds the battery backed RAM.  When that is all of it
+    // the mapped file is the RAM, otherwise the RAM lives in memory (shared
+    // with forks until written) and the battery backed part is copied to the
+    // file at each flush.
+    CowBuffer m_prg_ram_memory;
+    std::unique_ptr<SaveFile> m_save_file;
+    uint32_t m_prg_ram_size;
+    uint32_t m_prg_nvram_size;
+    CowBuffer m_chr_ram;
+    uint32_t m_chr_ram_size;
+    uint32_t m_chr_nvram_size;
 
     uint16_t m_mapper_id;
+    uint8_t m_sub_mapper_id;
+    TimingType m_timing_type;
+    Mirroring m_mirroring;
+    uint32_t m_crc32;
+    bool m_database_match;
     std::shared_ptr<nes::cart::mapper::Mapper> m_mapper;
 
-    inline void set_prg(const uint32_t addr, const uint8_t data) {
-        if (addr >= m_prg_mem.size()) {
-            m_prg_mem.resize(addr + 1);
+    static const uint16_t ADDR_MAPPER_BEGIN = 0x4020;
+    static const uint16_t ADDR_CHR_END = 0x1FFF;
+
+    // For fork()
+    Cart(const Cart &cart);
+
+    const bool prg_ram_in_save_file() const {
+        return m_save_file != nullptr && m_save_file->size() == m_prg_ram_size;
+    }
+    const uint8_t *prg_ram() const {
+        return prg_ram_in_save_file() ? m_save_file->data() : m_prg_ram_memory.data();
+    }
+    // nullptr while a fork shares it
+    uint8_t *writable_prg_ram() {
+        if (prg_ram_in_save_file()) {
+            return m_save_file->data();
         }
-        m_prg_mem[addr] = data;
+        return m_prg_ram_memory.shared() ? nullptr : m_prg_ram_memory.writable_data();
     }
+    // Copy the battery backed RAM to the save file when it isn't mapped there
+    void store_prg_nvram();
 
-    inline void set_chr(const uint32_t addr, const uint8_t data) {
-        if (addr >= m_chr_mem.size()) {
-            m_chr_mem.resize(addr + 1);
-        }
-        m_chr_mem[addr] = data;
+    // First write to RAM a fork still shares, takes a copy and maps it writable
+    void unshare_prg_ram();
+    void unshare_chr_ram();
+
+    static uint32_t round_up(const uint32_t size, const uint32_t multiple) {
+        return (size + multiple - 1) / multiple * multiple;
     }
+
+    void parse_ines1(uint32_t &prg_ram_size, uint32_t &chr_ram_size);
+    void parse_ines2(uint32_t &prg_ram_size, uint32_t &chr_ram_size);
+    void apply_database(const RomDatabase &database, uint32_t &prg_ram_size, uint32_t &chr_ram_size);
+    void setup_ram(const uint32_t prg_ram_size, const uint32_t chr_ram_size, const bool save_battery);
 };
 
 }} // nes::cart
\ No newline at end of file
@@ -27,6 +27,7 @@ Emulation of the Nintendo Entertainment System Cartridge
 
 Links:
 - https://wiki.nesdev.com/w/index.php/INES
+- https://wiki.nesdev.com/w/index.php/NES_2.0
 *******************************************************************************/
 
 #pragma once
@@ -37,6 +38,12 @@ namespace nes { namespace cart {
 
 const char MAGIC[] = {0x4E, 0x45, 0x53, 0x1A}; // NES followed by MS-DOS EOF
 
+// Value of flags7.ines2 for an iNES2 header
+const uint8_t INES2_ID = 2;
+
+// ROM size MSB nibble that switches the size to exponent-multiplier notation
+const uint8_t INES2_ROM_SIZE_EXPONENT = 0x0F;
+
 enum TimingType {
     NTSC = 0,
     PAL = 1,
@@ -44,6 +51,14 @@ enum TimingType {
     DENDY = 3
 };
 
+enum Mirroring {
+    MIRROR_HORIZONTAL = 0,
+    MIRROR_VERTICAL = 1,
+    MIRROR_FOUR_SCREEN = 2,
+    MIRROR_SINGLE_SCREEN_LOW = 3,
+    MIRROR_SINGLE_SCREEN_HIGH = 4
+};
+
 enum ExtDeviceType {
     UNSPECIFIED = 0x00, // Unspecified
     STANDARD_CONTROLLER = 0x01, // Standard NES/Famicom controllers
@@ -95,6 +110,7 @@ enum ExtDeviceType {
     CITY_PATROLMAN_LIGHTBUN = 0x2F // City Patrolman Lightgun
 };
 
+// Bit fields are listed least significant bit first
 #pragma pack(push, 1)
 union Header {
     struct {
@@ -103,38 +119,38 @@ union Header {
         uint8_t num_chr_banks;
         union {
             struct {
-                uint8_t mapper_id_low:4;
-                bool ignore_mirroring:1;
-                bool contains_trainer:1;
-                bool contains_battery_backed_ram:1;
                 bool mirror_vertical:1;
+                bool contains_battery_backed_ram:1;
+                bool contains_trainer:1;
+                bool ignore_mirroring:1;
+                uint8_t mapper_id_low:4;
             };
             uint8_t bits;
         } flags6;
         union {
             struct {
-                uint8_t mapper_id_high:4;
-                uint8_t ines2:2;
-                bool play_choice_10:1;
                 bool vs_unisystem:1;
+                bool play_choice_10:1;
+                uint8_t ines2:2;
+                uint8_t mapper_id_high:4;
             };
             uint8_t bits;
         } flags7;
         uint8_t num_prg_ram_banks;
         union {
             struct {
-                uint8_t unused1:7;
                 bool tv_system_pal:1;
+                uint8_t unused1:7;
             };
             uint8_t bits;
         } flags9;
         union {
             struct {
+                uint8_t tv_system:2;
                 uint8_t unused1:2;
-                bool has_bus_conflicts:1;
                 bool no_prg_ram:1;
+                bool has_bus_conflicts:1;
                 uint8_t unused2:2;
-                uint8_t tv_system:2;
             };
             uint8_t bits;
         } flags10;
@@ -146,19 +162,19 @@ union Header {
         uint8_t num_chr_banks_low;
         union {
             struct {
-                uint8_t mapper_id_low:4;
-                bool ignore_mirroring:1;
-                bool contains_trainer:1;
-                bool contains_battery_backed_ram:1;
                 bool mirror_vertical:1;
+                bool contains_battery_backed_ram:1;
+                bool contains_trainer:1;
+                bool ignore_mirroring:1;
+                uint8_t mapper_id_low:4;
             };
             uint8_t bits;
         } flags6;
         union {
             struct {
-                uint8_t mapper_id_high:4;
+                uint8_t console_type:2;
                 uint8_t ines2:2;
-                bool console_type:2;
+                uint8_t mapper_id_high:4;
             };
             uint8_t bits;
         } flags7;
@@ -179,21 +195,21 @@ union Header {
         union {
             struct {
                 uint8_t prg_ram_shift_count:4;
-                uint8_t prg_flash_shift_count:4;
+                uint8_t prg_nvram_shift_count:4;
             };
             uint8_t bits;
         } prg_ram;
         union {
             struct {
                 uint8_t chr_ram_shift_count:4;
-                uint8_t chr_flash_shift_count:4;
+                uint8_t chr_nvram_shift_count:4;
             };
             uint8_t bits;
         } chr_ram;
         union {
             struct {
+                uint8_t timing_type:2;
                 uint8_t unused1:6;
-                TimingType timing_type:2;
             };
             uint8_t bits;
         } timing;
@@ -203,22 +219,22 @@ union Header {
                 uint8_t hardware_type:4;
             };
             struct {
-                uint8_t unused1:4;
                 uint8_t extended_console_type:4;
+                uint8_t unused1:4;
             };
             uint8_t bits;
         } system;
         union {
             struct {
-                uint8_t unused1:6;
                 uint8_t num_misc_roms:2;
+                uint8_t unused1:6;
             };
             uint8_t bits;
-        } mist_roms;
+        } misc_roms;
         union {
             struct {
+                uint8_t default_exp_device_id:6;
                 uint8_t unused1:2;
-                ExtDeviceType default_exp_device_id:6;
             };
             uint8_t bits;
         } exp_device;
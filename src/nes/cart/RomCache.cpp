@@ -0,0 +1,91 @@
+/*******************************************************************************
+MIT License
+
+Copyright (c) 2020 Chris Luby
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+/*******************************************************************************
+Process wide cache of immutable ROM images keyed by a hash of their contents, so
+every cart running the same game shares one copy of PRG and CHR-ROM.  Entries
+live only as long as some cart still holds them.
+*******************************************************************************/
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <string>
+#include <memory>
+#include <mutex>
+
+#include <utils/fnv1a.hpp>
+#include <nes/cart/RomCache.hpp>
+
+namespace nes { namespace cart {
+
+RomCache &RomCache::instance() {
+    static RomCache cache;
+    return cache;
+}
+
+std::shared_ptr<const RomImage> RomCache::load(const std::string &filename, const bool memory_map) {
+    return insert(RomImage::load(filename, memory_map));
+}
+
+std::shared_ptr<const RomImage> RomCache::insert(std::vector<uint8_t> &&data) {
+    return insert(std::make_shared<const RomImage>(std::move(data)));
+}
+
+const size_t RomCache::size() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    size_t live = 0;
+    for (const auto &entry : m_images) {
+        if (!entry.second.expired()) {
+            live++;
+        }
+    }
+    return live;
+}
+
+/**
+ * Hand back an existing image with the same contents, otherwise add this one.
+ * The hash only narrows the search, contents are compared before sharing.
+ */
+std::shared_ptr<const RomImage> RomCache::insert(std::shared_ptr<const RomImage> image) {
+    const uint64_t hash = utils::fnv1a_64(image->data(), image->size());
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto range = m_images.equal_range(hash);
+    for (auto it = range.first; it != range.second;) {
+        auto cached = it->second.lock();
+        if (cached == nullptr) {
+            // Every cart using it is gone
+            it = m_images.erase(it);
+        } else if (cached->size() == image->size() && memcmp(cached->data(), image->data(), image->size()) == 0) {
+            return cached;
+        } else {
+            it++;
+        }
+    }
+
+    m_images.emplace(hash, image);
+    return image;
+}
+
+}} // nes::cart
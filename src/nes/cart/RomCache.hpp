@@ -0,0 +1,65 @@
+/*******************************************************************************
+MIT License
+
+Copyright (c) 2020 Chris Luby
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+/*******************************************************************************
+Process wide cache of immutable ROM images keyed by a hash of their contents, so
+every cart running the same game shares one copy of PRG and CHR-ROM.  Entries
+live only as long as some cart still holds them.
+*******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include <nes/cart/RomImage.hpp>
+
+namespace nes { namespace cart {
+
+class RomCache {
+public:
+    static RomCache &instance();
+
+    // Load a ROM file, returning the cached image if the contents were seen before
+    std::shared_ptr<const RomImage> load(const std::string &filename, const bool memory_map);
+
+    // Cache an image built in memory
+    std::shared_ptr<const RomImage> insert(std::vector<uint8_t> &&data);
+
+    // Number of live images
+    const size_t size();
+
+private:
+    RomCache() = default;
+
+    std::shared_ptr<const RomImage> insert(std::shared_ptr<const RomImage> image);
+
+    std::mutex m_mutex;
+    std::unordered_multimap<uint64_t, std::weak_ptr<const RomImage>> m_images;
+};
+
+}} // nes::cart
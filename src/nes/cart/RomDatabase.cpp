@@ -0,0 +1,203 @@
+/*******************************************************************************
+MIT License
+
+Copyright (c) 2020 Chris Luby
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+/*******************************************************************************
+Database of known cartridges used to correct bad iNES headers.  The file is a
+small header followed by fixed size records sorted by the CRC-32 of PRG+CHR-ROM,
+memory mapped and binary searched so opening it costs nothing up front.
+*******************************************************************************/
+
+#include <stdexcept>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <string>
+#include <memory>
+
+#include <utils/string_format.hpp>
+#include <utils/MappedFile.hpp>
+#include <nes/cart/Header.hpp>
+#include <nes/cart/RomDatabase.hpp>
+
+namespace nes { namespace cart {
+
+const char RomDatabase::MAGIC[6] = {0x4E, 0x45, 0x53, 0x44, 0x42, 0x1A}; // NESDB followed by MS-DOS EOF
+
+namespace {
+
+uint32_t read_u32(const uint8_t *data) {
+    return data[0] | data[1] << 8 | data[2] << 16 | (uint32_t)data[3] << 24;
+}
+
+void write_u32(uint8_t *data, const uint32_t value) {
+    data[0] = value & 0xFF;
+    data[1] = (value >> 8) & 0xFF;
+    data[2] = (value >> 16) & 0xFF;
+    data[3] = value >> 24;
+}
+
+} // anonymous
+
+RomDatabase::RomDatabase(const std::string &filename)
+    : m_file(std::make_unique<utils::MappedFile>(filename)) {
+    const uint8_t *data = m_file->data();
+    if (m_file->size() < HEADER_SIZE || memcmp(data, MAGIC, sizeof(MAGIC)) != 0) {
+        throw std::runtime_error(utils::string_format("%s is not a ROM database", filename.c_str()));
+    }
+
+    const uint16_t version = data[6] | data[7] << 8;
+    if (version != VERSION) {
+        throw std::runtime_error(utils::string_format("ROM database %s is version %u but expected %u", filename.c_str(), version, VERSION));
+    }
+
+    m_num_records = read_u32(data + 8);
+    if (m_file->size() < HEADER_SIZE + (uint64_t)m_num_records * sizeof(Record)) {
+        throw std::runtime_error(utils::string_format("ROM database %s is truncated", filename.c_str()));
+    }
+    m_records = data + HEADER_SIZE;
+}
+
+/**
+ * Binary search on the leading CRC of each record, reading the key straight
+ * out of the mapping so only the touched pages get loaded
+ */
+const bool RomDatabase::find(const uint32_t crc32, Record &record) const {
+    uint32_t low = 0;
+    uint32_t high = m_num_records;
+    while (low < high) {
+        const uint32_t mid = low + (high - low) / 2;
+        if (read_u32(m_records + mid * sizeof(Record)) < crc32) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    if (low < m_num_records && read_u32(m_records + low * sizeof(Record)) == crc32) {
+        const uint8_t *found = m_records + low * sizeof(Record);
+        record.crc32 = crc32;
+        record.mapper_id = found[4] | found[5] << 8;
+        record.sub_mapper_id = found[6];
+        record.mirroring = found[7];
+        record.timing_type = found[8];
+        memset(record.reserved, 0, sizeof(record.reserved));
+        record.prg_ram_size = read_u32(found + 12);
+        record.prg_nvram_size = read_u32(found + 16);
+        record.chr_ram_size = read_u32(found + 20);
+        record.chr_nvram_size = read_u32(found + 24);
+        return true;
+    }
+
+    return false;
+}
+
+void RomDatabase::write(const std::string &filename, std::vector<Record> records) {
+    std::sort(records.begin(), records.end(), [](const Record &a, const Record &b) {
+        return a.crc32 < b.crc32;
+    });
+
+    std::vector<uint8_t> data(HEADER_SIZE + records.size() * sizeof(Record), 0x00);
+    memcpy(data.data(), MAGIC, sizeof(MAGIC));
+    data[6] = VERSION & 0xFF;
+    data[7] = VERSION >> 8;
+    write_u32(data.data() + 8, (uint32_t)records.size());
+
+    uint8_t *out = data.data() + HEADER_SIZE;
+    for (const auto &record : records) {
+        write_u32(out, record.crc32);
+        out[4] = record.mapper_id & 0xFF;
+        out[5] = record.mapper_id >> 8;
+        out[6] = record.sub_mapper_id;
+        out[7] = record.mirroring;
+        out[8] = record.timing_type;
+        write_u32(out + 12, record.prg_ram_size);
+        write_u32(out + 16, record.prg_nvram_size);
+        write_u32(out + 20, record.chr_ram_size);
+        write_u32(out + 24, record.chr_nvram_size);
+        out += sizeof(Record);
+    }
+
+    std::ofstream ofs(filename, std::ofstream::binary);
+    ofs.write((const char *)data.data(), data.size());
+    if (!ofs) {
+        throw std::runtime_error(utils::string_format("Failed to write ROM database %s", filename.c_str()));
+    }
+}
+
+std::vector<RomDatabase::Record> RomDatabase::read_csv(const std::string &csv_filename) {
+    std::ifstream file(csv_filename);
+    if (!file) {
+        throw std::runtime_error(utils::string_format("Unable to open ROM list %s", csv_filename.c_str()));
+    }
+
+    std::vector<Record> records;
+    std::string line;
+    uint32_t line_number = 0;
+    while (std::getline(file, line)) {
+        line_number++;
+        if (line.find_first_not_of(" \t\r") == std::string::npos || line[0] == '#') {
+            continue;
+        }
+
+        std::istringstream fields(line);
+        std::string field;
+        uint64_t values[9];
+        size_t count = 0;
+        try {
+            while (count < 9 && std::getline(fields, field, ',')) {
+                size_t end = 0;
+                values[count] = std::stoull(field, &end, count == 0 ? 16 : 10);
+                if (field.find_first_not_of(" \t\r", end) != std::string::npos) {
+                    break;
+                }
+                count++;
+            }
+        } catch (const std::logic_error &) {
+        }
+        if (count != 9 || std::getline(fields, field, ',') || values[0] > UINT32_MAX || values[1] > UINT16_MAX ||
+            values[2] > UINT8_MAX || values[3] > MIRROR_SINGLE_SCREEN_HIGH || values[4] > DENDY ||
+            std::any_of(values + 5, values + 9, [](const uint64_t size) { return size > UINT32_MAX; })) {
+            throw std::runtime_error(utils::string_format(
+                "%s:%u expected CRC32,MAPPER,SUB_MAPPER,MIRRORING,TIMING,PRG_RAM,PRG_NVRAM,CHR_RAM,CHR_NVRAM", csv_filename.c_str(), line_number
+            ));
+        }
+
+        Record record = {};
+        record.crc32 = (uint32_t)values[0];
+        record.mapper_id = (uint16_t)values[1];
+        record.sub_mapper_id = (uint8_t)values[2];
+        record.mirroring = (uint8_t)values[3];
+        record.timing_type = (uint8_t)values[4];
+        record.prg_ram_size = (uint32_t)values[5];
+        record.prg_nvram_size = (uint32_t)values[6];
+        record.chr_ram_size = (uint32_t)values[7];
+        record.chr_nvram_size = (uint32_t)values[8];
+        records.push_back(record);
+    }
+    return records;
+}
+
+}} // nes::cart
@@ -0,0 +1,97 @@
+/*******************************************************************************
+MIT License
+
+Copyright (c) 2020 Chris Luby
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+/*******************************************************************************
+Database of known cartridges used to correct bad iNES headers.  The file is a
+small header followed by fixed size records sorted by the CRC-32 of PRG+CHR-ROM,
+memory mapped and binary searched so opening it costs nothing up front.
+
+File layout (all little endian):
+  0x00: Magic "NESDB" 0x1A
+  0x06: Version (uint16_t)
+  0x08: Record count (uint32_t)
+  0x0C: Records
+
+Databases are built from a CSV with a line per ROM (blank lines and lines
+starting with # are skipped):
+  CRC32,MAPPER,SUB_MAPPER,MIRRORING,TIMING,PRG_RAM,PRG_NVRAM,CHR_RAM,CHR_NVRAM
+with the CRC-32 in hex, MIRRORING and TIMING as the Mirroring and TimingType
+values, and RAM sizes in bytes.
+*******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <memory>
+
+#include <utils/MappedFile.hpp>
+
+namespace nes { namespace cart {
+
+class RomDatabase {
+public:
+    static const uint16_t VERSION = 1;
+
+    #pragma pack(push, 1)
+    struct Record {
+        uint32_t crc32; // PRG+CHR-ROM
+        uint16_t mapper_id;
+        uint8_t sub_mapper_id;
+        uint8_t mirroring; // Mirroring
+        uint8_t timing_type; // TimingType
+        uint8_t reserved[3];
+        uint32_t prg_ram_size;
+        uint32_t prg_nvram_size;
+        uint32_t chr_ram_size;
+        uint32_t chr_nvram_size;
+    };
+    #pragma pack(pop)
+
+    // Throws std::runtime_error if the file isn't a database
+    RomDatabase(const std::string &filename);
+
+    // Returns false if the ROM isn't known
+    const bool find(const uint32_t crc32, Record &record) const;
+
+    const uint32_t size() const {
+        return m_num_records;
+    }
+
+    // Write records (any order) out as a database file
+    static void write(const std::string &filename, std::vector<Record> records);
+
+    // Throws std::runtime_error naming the line if the CSV is malformed
+    static std::vector<Record> read_csv(const std::string &csv_filename);
+
+private:
+    static const char MAGIC[6];
+    static const uint32_t HEADER_SIZE = 12;
+
+    std::unique_ptr<utils::MappedFile> m_file;
+    const uint8_t *m_records;
+    uint32_t m_num_records;
+};
+
+}} // nes::cart
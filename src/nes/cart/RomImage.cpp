@@ -0,0 +1,245 @@
+/*******************************************************************************
+MIT License
+
+Copyright (c) 2020 Chris Luby
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+/*******************************************************************************
+Raw bytes of a ROM file, either memory mapped straight from disk or read into
+the heap.  The image is immutable so carts can share it.
+
+Gzipped ROMs and zip archives are inflated straight from the mapped file into
+the image in one pass.  The first .nes entry of a zip is used (or the only
+entry if none end in .nes).
+
+Links:
+- https://www.rfc-editor.org/rfc/rfc1952
+- https://pkware.cachefly.net/webdocs/casestudies/APPNOTE.TXT
+*******************************************************************************/
+
+#include <stdexcept>
+#include <fstream>
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <memory>
+#include <algorithm>
+#include <cctype>
+
+#include <zlib.h>
+
+#include <utils/string_format.hpp>
+#include <utils/crc32.hpp>
+#include <utils/MappedFile.hpp>
+#include <nes/cart/RomImage.hpp>
+
+namespace nes { namespace cart {
+
+RomImage::RomImage(std::unique_ptr<utils::MappedFile> file)
+    : m_file(std::move(file)) {
+    m_data = m_file->data();
+    m_size = m_file->size();
+}
+
+RomImage::RomImage(std::vector<uint8_t> &&data)
+    : m_heap(std::move(data)) {
+    m_data = m_heap.data();
+    m_size = m_heap.size();
+}
+
+std::shared_ptr<const RomImage> RomImage::load(const std::string &filename, const bool memory_map) {
+    // Compressed files are read through a mapping and only the ROM is copied out
+    if (memory_map || compressed(filename)) {
+        auto file = std::make_unique<utils::MappedFile>(filename);
+        const uint8_t *data = file->data();
+        const size_t size = file->size();
+        if (size >= 4 && (read_le32(data) & 0xFFFFFF) == GZIP_MAGIC) {
+            return std::make_shared<const RomImage>(gunzip(filename, data, size));
+        } else if (size >= 4 && read_le32(data) == ZIP_LOCAL_HEADER_MAGIC) {
+            return std::make_shared<const RomImage>(unzip(filename, data, size));
+        }
+        return std::make_shared<const RomImage>(std::move(file));
+    }
+
+    std::ifstream ifs(filename, std::ifstream::binary | std::ifstream::ate);
+    if (!ifs.is_open()) {
+        throw std::runtime_error(utils::string_format("Failed to load ROM %s", filename.c_str()));
+    }
+    std::vector<uint8_t> data((size_t)ifs.tellg());
+    ifs.seekg(0);
+    ifs.read((char *)data.data(), data.size());
+    if (!ifs) {
+        throw std::runtime_error(utils::string_format("Failed to read ROM %s", filename.c_str()));
+    }
+    return std::make_shared<const RomImage>(std::move(data));
+}
+
+const bool RomImage::compressed(const std::string &filename) {
+    std::ifstream ifs(filename, std::ifstream::binary);
+    uint8_t magic[4] = { 0x00, 0x00, 0x00, 0x00 };
+    ifs.read((char *)magic, sizeof(magic));
+    const uint32_t value = read_le32(magic);
+    return (value & 0xFFFFFF) == GZIP_MAGIC || value == ZIP_LOCAL_HEADER_MAGIC;
+}
+
+/**
+ * The trailer holds the size of the ROM, so the image is usually allocated once
+ */
+std::vector<uint8_t> RomImage::gunzip(const std::string &filename, const uint8_t *data, const size_t size) {
+    if (size < GZIP_MIN_SIZE) {
+        throw std::runtime_error(utils::string_format("ROM %s is not a valid gzip file", filename.c_str()));
+    }
+
+    std::vector<uint8_t> out;
+    out.reserve(reserve_size(read_le32(data + size - 4), size));
+    // zlib handles the gzip header and checks the trailer CRC
+    inflate(filename, data, size, out, MAX_WBITS + 16);
+    return out;
+}
+
+/**
+ * Find the ROM in the central directory and inflate it from its local entry
+ */
+std::vector<uint8_t> RomImage::unzip(const std::string &filename, const uint8_t *data, const size_t size) {
+    auto invalid = [&filename]() {
+        return std::runtime_error(utils::string_format("ROM %s is not a valid zip file", filename.c_str()));
+    };
+
+    // The end record sits at the very end, before an optional comment
+    if (size < ZIP_END_SIZE) {
+        throw invalid();
+    }
+    size_t end = size - ZIP_END_SIZE;
+    const size_t end_limit = end > UINT16_MAX ? end - UINT16_MAX : 0;
+    while (read_le32(data + end) != ZIP_END_MAGIC) {
+        if (end == end_limit) {
+            throw invalid();
+        }
+        end--;
+    }
+    const uint16_t num_entries = read_le16(data + end + 10);
+    size_t entry = read_le32(data + end + 16);
+
+    // Prefer the first .nes entry, otherwise an archive holding a single file
+    bool found = false;
+    size_t rom_entry = 0;
+    uint16_t num_files = 0;
+    for (uint16_t i = 0; i < num_entries; i++) {
+        if (entry + ZIP_CENTRAL_HEADER_SIZE > size || read_le32(data + entry) != ZIP_CENTRAL_HEADER_MAGIC) {
+            throw invalid();
+        }
+        const uint16_t name_size = read_le16(data + entry + 28);
+        const uint16_t extra_size = read_le16(data + entry + 30);
+        const uint16_t comment_size = read_le16(data + entry + 32);
+        if (entry + ZIP_CENTRAL_HEADER_SIZE + name_size > size) {
+            throw invalid();
+        }
+        std::string name((const char *)data + entry + ZIP_CENTRAL_HEADER_SIZE, name_size);
+        std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+
+        // Directories end in a slash
+        if (name.size() > 0 && name.back() != '/') {
+            if (num_files == 0) {
+                rom_entry = entry;
+            }
+            num_files++;
+            if (name.size() > 4 && name.compare(name.size() - 4, 4, ".nes") == 0) {
+                rom_entry = entry;
+                found = true;
+                break;
+            }
+        }
+        entry += ZIP_CENTRAL_HEADER_SIZE + name_size + extra_size + comment_size;
+    }
+    if (!found && num_files != 1) {
+        throw std::runtime_error(utils::string_format("ROM archive %s doesn't contain a .nes file", filename.c_str()));
+    }
+
+    const uint16_t method = read_le16(data + rom_entry + 10);
+    const uint32_t crc = read_le32(data + rom_entry + 16);
+    const uint32_t compressed_size = read_le32(data + rom_entry + 20);
+    const uint32_t uncompressed_size = read_le32(data + rom_entry + 24);
+    const size_t local = read_le32(data + rom_entry + 42);
+    if (compressed_size == UINT32_MAX || uncompressed_size == UINT32_MAX) {
+        throw std::runtime_error(utils::string_format("ROM archive %s is a zip64 archive, which isn't supported", filename.c_str()));
+    }
+    if (local + ZIP_LOCAL_HEADER_SIZE > size || read_le32(data + local) != ZIP_LOCAL_HEADER_MAGIC) {
+        throw invalid();
+    }
+    const size_t start = local + ZIP_LOCAL_HEADER_SIZE + read_le16(data + local + 26) + read_le16(data + local + 28);
+    if (start + compressed_size > size) {
+        throw invalid();
+    }
+
+    std::vector<uint8_t> out;
+    if (method == ZIP_STORED) {
+        out.assign(data + start, data + start + compressed_size);
+    } else if (method == ZIP_DEFLATED) {
+        out.reserve(reserve_size(uncompressed_size, compressed_size));
+        inflate(filename, data + start, compressed_size, out, -MAX_WBITS);
+    } else {
+        throw std::runtime_error(utils::string_format("ROM archive %s uses compression method %u, only deflate is supported", filename.c_str(), method));
+    }
+
+    if (out.size() != uncompressed_size || utils::crc32(out.data(), out.size()) != crc) {
+        throw std::runtime_error(utils::string_format("ROM archive %s is corrupt", filename.c_str()));
+    }
+    return out;
+}
+
+/**
+ * The size in the file isn't trusted for more than a small multiple of the
+ * compressed data, past that inflate() grows the buffer as the data arrives
+ */
+const size_t RomImage::reserve_size(const uint32_t uncompressed_size, const size_t compressed_size) {
+    return std::min<size_t>(uncompressed_size, compressed_size * MAX_RESERVE_RATIO);
+}
+
+/**
+ * Inflate into the spare capacity of out, growing it if the expected size was wrong
+ */
+void RomImage::inflate(const std::string &filename, const uint8_t *data, const size_t size, std::vector<uint8_t> &out, const int window_bits) {
+    z_stream stream = {};
+    if (inflateInit2(&stream, window_bits) != Z_OK) {
+        throw std::runtime_error(utils::string_format("Failed to start decompressing %s", filename.c_str()));
+    }
+
+    stream.next_in = (Bytef *)data;
+    stream.avail_in = (uInt)std::min<size_t>(size, UINT32_MAX);
+    int result = Z_OK;
+    while (result == Z_OK) {
+        if (out.size() == out.capacity()) {
+            out.reserve(std::max<size_t>(out.capacity() * 2, INFLATE_CHUNK_SIZE));
+        }
+        const size_t used = out.size();
+        out.resize(out.capacity());
+        stream.next_out = out.data() + used;
+        stream.avail_out = (uInt)std::min<size_t>(out.size() - used, UINT32_MAX);
+        result = ::inflate(&stream, Z_NO_FLUSH);
+        out.resize(out.size() - stream.avail_out);
+    }
+    inflateEnd(&stream);
+
+    if (result != Z_STREAM_END) {
+        throw std::runtime_error(utils::string_format("Failed to decompress %s (zlib error %d)", filename.c_str(), result));
+    }
+}
+
+}} // nes::cart
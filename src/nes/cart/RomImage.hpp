@@ -0,0 +1,107 @@
+/*******************************************************************************
+MIT License
+
+Copyright (c) 2020 Chris Luby
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+/*******************************************************************************
+Raw bytes of a ROM file, either memory mapped straight from disk or read into
+the heap.  The image is immutable so carts can share it.
+
+Gzipped ROMs and zip archives are inflated straight from the mapped file into
+the image in one pass.  The first .nes entry of a zip is used (or the only
+entry if none end in .nes).
+
+Links:
+- https://www.rfc-editor.org/rfc/rfc1952
+- https://pkware.cachefly.net/webdocs/casestudies/APPNOTE.TXT
+*******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <string>
+#include <memory>
+
+#include <utils/MappedFile.hpp>
+
+namespace nes { namespace cart {
+
+class RomImage {
+public:
+    // Memory map the file
+    RomImage(std::unique_ptr<utils::MappedFile> file);
+    // Take ownership of bytes already in memory
+    RomImage(std::vector<uint8_t> &&data);
+
+    // Load a ROM file, memory mapped or read into the heap.  Compressed files
+    // always end up on the heap.
+    static std::shared_ptr<const RomImage> load(const std::string &filename, const bool memory_map);
+
+    const uint8_t *data() const {
+        return m_data;
+    }
+
+    const size_t size() const {
+        return m_size;
+    }
+
+    const bool memory_mapped() const {
+        return m_file != nullptr;
+    }
+
+private:
+    static const uint32_t GZIP_MAGIC = 0x088B1F;
+    static const uint32_t ZIP_LOCAL_HEADER_MAGIC = 0x04034B50;
+    static const uint32_t ZIP_CENTRAL_HEADER_MAGIC = 0x02014B50;
+    static const uint32_t ZIP_END_MAGIC = 0x06054B50;
+    static const uint16_t ZIP_STORED = 0;
+    static const uint16_t ZIP_DEFLATED = 8;
+    static const size_t GZIP_MIN_SIZE = 18;
+    static const size_t ZIP_LOCAL_HEADER_SIZE = 30;
+    static const size_t ZIP_CENTRAL_HEADER_SIZE = 46;
+    static const size_t ZIP_END_SIZE = 22;
+    static const size_t INFLATE_CHUNK_SIZE = 64 * 1024;
+    static const size_t MAX_RESERVE_RATIO = 16; // ROMs rarely shrink more than this
+
+    static const uint16_t read_le16(const uint8_t *data) {
+        return data[0] | data[1] << 8;
+    }
+    static const uint32_t read_le32(const uint8_t *data) {
+        return data[0] | data[1] << 8 | data[2] << 16 | (uint32_t)data[3] << 24;
+    }
+
+    static const bool compressed(const std::string &filename);
+
+    static std::vector<uint8_t> gunzip(const std::string &filename, const uint8_t *data, const size_t size);
+    static std::vector<uint8_t> unzip(const std::string &filename, const uint8_t *data, const size_t size);
+    static const size_t reserve_size(const uint32_t uncompressed_size, const size_t compressed_size);
+    static void inflate(const std::string &filename, const uint8_t *data, const size_t size, std::vector<uint8_t> &out, const int window_bits);
+
+    std::unique_ptr<utils::MappedFile> m_file;
+    std::vector<uint8_t> m_heap;
+
+    const uint8_t *m_data;
+    size_t m_size;
+};
+
+}} // nes::cart
@@ -0,0 +1,105 @@
+/*******************************************************************************
+MIT License
+
+Copyright (c) 2020 Chris Luby
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+/*******************************************************************************
+Battery backed RAM kept in a .sav file next to the ROM.  The RAM is the file
+mapping itself, so the emulator writes to it like any other memory and nothing
+is copied.  flush() asks a background thread to push the dirty pages to disk,
+so the emulation thread never waits on the disk and a power cut loses at most
+the last few frames.
+*******************************************************************************/
+
+#include <iostream>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include <nes/cart/SaveFile.hpp>
+
+namespace nes { namespace cart {
+
+SaveFile::SaveFile(const std::string &filename, const size_t size)
+    : m_filename(filename)
+    , m_file(filename, size)
+    , m_flusher(&SaveFile::run_flusher, this) {
+}
+
+SaveFile::~SaveFile() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_flush_requested.notify_one();
+    m_flusher.join();
+
+    sync();
+}
+
+std::string SaveFile::filename_for(const std::string &rom_filename) {
+    // Only look for the extension in the last path component
+    const size_t slash = rom_filename.find_last_of("/\\");
+    const size_t dot = rom_filename.find_last_of('.');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+        return rom_filename + ".sav";
+    }
+    return rom_filename.substr(0, dot) + ".sav";
+}
+
+void SaveFile::flush() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_flush_pending) {
+            return;
+        }
+        m_flush_pending = true;
+    }
+    m_flush_requested.notify_one();
+}
+
+void SaveFile::sync() {
+    if (!m_file.sync()) {
+        std::cerr << "Failed to write " << m_filename << " to disk" << std::endl;
+    }
+}
+
+void SaveFile::run_flusher() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_flush_requested.wait(lock, [this] { return m_flush_pending || m_stop; });
+        if (m_stop) {
+            return;
+        }
+        m_flush_pending = false;
+
+        // Let the emulator keep asking while the disk catches up
+        lock.unlock();
+        sync();
+        lock.lock();
+    }
+}
+
+}} // nes::cart
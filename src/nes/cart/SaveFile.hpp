@@ -0,0 +1,91 @@
+/*******************************************************************************
+MIT License
+
+Copyright (c) 2020 Chris Luby
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+/*******************************************************************************
+Battery backed RAM kept in a .sav file next to the ROM.  The RAM is the file
+mapping itself, so the emulator writes to it like any other memory and nothing
+is copied.  flush() asks a background thread to push the dirty pages to disk,
+so the emulation thread never waits on the disk and a power cut loses at most
+the last few frames.
+*******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include <utils/WritableMappedFile.hpp>
+
+namespace nes { namespace cart {
+
+class SaveFile {
+public:
+    // The file is created (zero filled) if there is no save yet
+    SaveFile(const std::string &filename, const size_t size);
+    // Stops the flusher and syncs one last time
+    ~SaveFile();
+
+    SaveFile(const SaveFile &) = delete;
+    SaveFile &operator=(const SaveFile &) = delete;
+
+    // The ROM filename with its extension swapped for .sav
+    static std::string filename_for(const std::string &rom_filename);
+
+    uint8_t *data() const {
+        return m_file.data();
+    }
+
+    const size_t size() const {
+        return m_file.size();
+    }
+
+    const std::string &filename() const {
+        return m_filename;
+    }
+
+    // Start writing the dirty pages out in the background, requests made while
+    // a sync is running are folded into the next one
+    void flush();
+
+    // Block until everything written so far is on disk
+    void sync();
+
+private:
+    std::string m_filename;
+    utils::WritableMappedFile m_file;
+
+    std::mutex m_mutex;
+    std::condition_variable m_flush_requested;
+    bool m_flush_pending = false;
+    bool m_stop = false;
+    std::thread m_flusher;
+
+    void run_flusher();
+};
+
+}} // nes::cart
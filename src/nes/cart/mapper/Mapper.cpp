@@ -21,14 +21,138 @@ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
 OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 *******************************************************************************/
-
 /*******************************************************************************
 Emulation of the Mapper chip on the Nintendo Entertainment System Cartrige that
 intercepts / adstracts the system, cartrige, and PPU memory access
+
+Mappers publish which memory backs each 8KB window of the CPU address space and
+each 1KB window of the PPU pattern tables.  Reads index those tables directly,
+the mapper itself only runs when one of its registers is written.
 *******************************************************************************/
 
+#include <memory>
+#include <cstdint>
+
 #include <nes/cart/mapper/Mapper.hpp>
+#include <nes/cart/Cart.hpp>
 
 namespace nes { namespace cart { namespace mapper {
 
-}}} // nes::cart::mapper
\ No newline at end of file
+namespace {
+
+// Start of the bank'th size byte block, nullptr if memory can't hold one
+template<typename T>
+T *bank_base(T *memory, const uint32_t memory_size, const uint32_t size, const int32_t bank) {
+    const int32_t num_banks = memory_size / size;
+    if (memory == nullptr || num_banks == 0) {
+        return nullptr;
+    }
+    int32_t wrapped = bank % num_banks;
+    if (wrapped < 0) {
+        wrapped += num_banks;
+    }
+    return memory + wrapped * size;
+}
+
+} // anonymous
+
+Mapper::Mapper(std::shared_ptr<nes::cart::Cart> cart, uint16_t num_prg_banks, uint16_t num_chr_banks)
+    : m_cart(cart.get())
+    , m_num_prg_banks(num_prg_banks)
+    , m_num_chr_banks(num_chr_banks)
+    , m_prg_write_deferred(0x00)
+    , m_chr_write_deferred(0x00) {
+    for (uint8_t i = 0; i < PRG_NUM_WINDOWS; i++) {
+        m_prg_read[i] = nullptr;
+        m_prg_write[i] = nullptr;
+        m_prg_mask[i] = PRG_WINDOW_MASK;
+    }
+    for (uint8_t i = 0; i < CHR_NUM_WINDOWS; i++) {
+        m_chr_read[i] = nullptr;
+        m_chr_write[i] = nullptr;
+    }
+}
+
+void Mapper::map_prg_rom(const uint16_t addr, const uint32_t size, const int32_t bank) {
+    const uint8_t *base = bank_base(m_cart->m_prg_rom, m_cart->m_prg_rom_size, size, bank);
+    const uint8_t first = addr >> PRG_WINDOW_SHIFT;
+    for (uint8_t i = 0; i < size / PRG_WINDOW_SIZE; i++) {
+        m_prg_read[first + i] = base != nullptr ? base + i * PRG_WINDOW_SIZE : nullptr;
+        m_prg_write[first + i] = nullptr;
+        m_prg_mask[first + i] = PRG_WINDOW_MASK;
+        m_prg_write_deferred &= ~(1 << (first + i));
+    }
+}
+
+void Mapper::map_prg_ram(const uint16_t addr, const uint32_t size, const int32_t bank, const bool writable) {
+    const uint32_t ram_size = m_cart->m_prg_ram_size;
+    const uint8_t *base;
+    uint8_t *write_base; // nullptr while a fork shares the memory
+    uint16_t mask = PRG_WINDOW_MASK;
+    if (ram_size > 0 && ram_size < PRG_WINDOW_SIZE) {
+        // One small chip, the address lines above it aren't connected
+        base = m_cart->prg_ram();
+        write_base = writable ? m_cart->writable_prg_ram() : nullptr;
+        while (mask >= ram_size) {
+            mask >>= 1;
+        }
+    } else {
+        base = bank_base(m_cart->prg_ram(), ram_size, size, bank);
+        write_base = writable ? bank_base(m_cart->writable_prg_ram(), ram_size, size, bank) : nullptr;
+    }
+    const uint32_t stride = mask == PRG_WINDOW_MASK ? PRG_WINDOW_SIZE : 0;
+
+    const uint8_t first = addr >> PRG_WINDOW_SHIFT;
+    for (uint8_t i = 0; i < size / PRG_WINDOW_SIZE; i++) {
+        m_prg_read[first + i] = base != nullptr ? base + i * stride : nullptr;
+        m_prg_write[first + i] = write_base != nullptr ? write_base + i * stride : nullptr;
+        m_prg_mask[first + i] = mask;
+        if (writable && base != nullptr && write_base == nullptr) {
+            m_prg_write_deferred |= 1 << (first + i);
+        } else {
+            m_prg_write_deferred &= ~(1 << (first + i));
+        }
+    }
+}
+
+void Mapper::unmap_prg(const uint16_t addr, const uint32_t size) {
+    const uint8_t first = addr >> PRG_WINDOW_SHIFT;
+    for (uint8_t i = 0; i < size / PRG_WINDOW_SIZE; i++) {
+        m_prg_read[first + i] = nullptr;
+        m_prg_write[first + i] = nullptr;
+        m_prg_mask[first + i] = PRG_WINDOW_MASK;
+        m_prg_write_deferred &= ~(1 << (first + i));
+    }
+}
+
+void Mapper::map_chr(const uint16_t addr, const uint32_t size, const int32_t bank) {
+    const uint8_t first = addr >> CHR_WINDOW_SHIFT;
+    if (m_cart->m_chr_rom_size > 0) {
+        const uint8_t *base = bank_base(m_cart->m_chr_rom, m_cart->m_chr_rom_size, size, bank);
+        for (uint8_t i = 0; i < size / CHR_WINDOW_SIZE; i++) {
+            m_chr_read[first + i] = base != nullptr ? base + i * CHR_WINDOW_SIZE : nullptr;
+            m_chr_write[first + i] = nullptr;
+            m_chr_write_deferred &= ~(1 << (first + i));
+        }
+    } else {
+        const uint32_t chr_ram_size = (uint32_t)m_cart->m_chr_ram.size();
+        const uint8_t *base = bank_base(m_cart->m_chr_ram.data(), chr_ram_size, size, bank);
+        // nullptr while a fork shares the memory
+        uint8_t *write_base = m_cart->m_chr_ram.shared() ? nullptr : bank_base(m_cart->m_chr_ram.writable_data(), chr_ram_size, size, bank);
+        for (uint8_t i = 0; i < size / CHR_WINDOW_SIZE; i++) {
+            m_chr_read[first + i] = base != nullptr ? base + i * CHR_WINDOW_SIZE : nullptr;
+            m_chr_write[first + i] = write_base != nullptr ? write_base + i * CHR_WINDOW_SIZE : nullptr;
+            if (base != nullptr && write_base == nullptr) {
+                m_chr_write_deferred |= 1 << (first + i);
+            } else {
+                m_chr_write_deferred &= ~(1 << (first + i));
+            }
+        }
+    }
+}
+
+void Mapper::set_mirroring(const nes::cart::Mirroring mirroring) {
+    m_cart->m_mirroring = mirroring;
+}
+
+}}} // nes::cart::mapper
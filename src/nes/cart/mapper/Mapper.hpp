@@ -21,10 +21,13 @@ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
 OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 *******************************************************************************/
-
 /*******************************************************************************
 Emulation of the Mapper chip on the Nintendo Entertainment System Cartrige that
 intercepts / adstracts the system, cartrige, and PPU memory access
+
+Mappers publish which memory backs each 8KB window of the CPU address space and
+each 1KB window of the PPU pattern tables.  Reads index those tables directly,
+the mapper itself only runs when one of its registers is written.
 *******************************************************************************/
 
 #pragma once
@@ -32,6 +35,10 @@ intercepts / adstracts the system, cartrige, and PPU memory access
 #include <memory>
 #include <cstdint>
 
+#include <nes/State.hpp>
+#include <nes/Scheduler.hpp>
+#include <nes/cart/Header.hpp>
+
 // Forward declaration for Cart
 namespace nes { namespace cart {
 
@@ -43,26 +50,127 @@ namespace nes { namespace cart { namespace mapper {
 
 class Mapper {
 public:
-    Mapper(std::shared_ptr<nes::cart::Cart> cart, uint8_t num_prg_banks, uint8_t num_chr_banks)
-        : m_cart(cart)
-        , m_num_prg_banks(num_prg_banks)
-        , m_num_chr_banks(num_chr_banks) {
+    static const uint32_t PRG_WINDOW_SIZE = 8 * 1024;
+    static const uint8_t PRG_WINDOW_SHIFT = 13;
+    static const uint16_t PRG_WINDOW_MASK = 0x1FFF;
+    static const uint8_t PRG_NUM_WINDOWS = 8;
+    static const uint32_t CHR_WINDOW_SIZE = 1024;
+    static const uint8_t CHR_WINDOW_SHIFT = 10;
+    static const uint16_t CHR_WINDOW_MASK = 0x03FF;
+    static const uint8_t CHR_NUM_WINDOWS = 8;
+
+    Mapper(std::shared_ptr<nes::cart::Cart> cart, uint16_t num_prg_banks, uint16_t num_chr_banks);
+    virtual ~Mapper() = default;
+
+    // Put the registers back to their power on state and publish the banks
+    virtual void reset() = 0;
+
+    // Publish the banks selected by the current register state
+    virtual void update_banks() = 0;
+
+    // Copy of the registers for a forked cart, which then publishes the banks
+    virtual std::shared_ptr<Mapper> clone(std::shared_ptr<nes::cart::Cart> cart) const = 0;
+
+    // Register state for save states, the cart calls update_banks() after loading
+    virtual void save_state(StateWriter &state) const {
+    }
+    virtual void load_state(StateReader &state) {
     }
 
-    virtual void reset() = 0;
+    // Source of the current CPU cycle for mappers that care about timing
+    void connect_scheduler(std::shared_ptr<nes::Scheduler> scheduler) {
+        m_scheduler = scheduler;
+    }
+
+    // Writes from the CPU that didn't land in writable memory
+    virtual const bool cpu_write(const uint16_t addr, const uint8_t data) {
+        return false;
+    }
+
+    // State of the IRQ line driven by the mapper
+    virtual const bool irq() const {
+        return false;
+    }
 
-    // Map addresses in CPU read/write address space
-    virtual const bool cpu_map_read_addr(const uint16_t addr, uint32_t &mapped_addr) = 0;
-    virtual const bool cpu_map_write_addr(const uint16_t addr, uint32_t &mapped_addr, const uint8_t data) = 0;
+    // Mappers with a scanline counter clocked by PPU A12 (MMC3).  The bus works
+    // out how many times A12 rose and when the IRQ will be due, so the mapper
+    // never watches the PPU address bus.
+    static const uint32_t NO_SCANLINE_IRQ = UINT32_MAX;
+    virtual const bool scanline_counter() const {
+        return false;
+    }
+    virtual void clock_scanline_counter(const uint32_t count) {
+    }
+    // Clocks until the IRQ line asserts, NO_SCANLINE_IRQ if it won't
+    virtual const uint32_t scanline_clocks_until_irq() const {
+        return NO_SCANLINE_IRQ;
+    }
+
+    // Memory backing the window holding addr, nullptr if the cart doesn't respond there
+    const uint8_t *prg_read_bank(const uint16_t addr) const {
+        return m_prg_read[addr >> PRG_WINDOW_SHIFT];
+    }
+    uint8_t *prg_write_bank(const uint16_t addr) const {
+        return m_prg_write[addr >> PRG_WINDOW_SHIFT];
+    }
+    // Offset mask within the window, smaller than the window when RAM is mirrored
+    const uint16_t prg_mask(const uint16_t addr) const {
+        return m_prg_mask[addr >> PRG_WINDOW_SHIFT];
+    }
 
-    // Map addresses in PPU read/write address space
-    virtual const bool ppu_map_read_addr(const uint16_t addr, uint32_t &mapped_addr) = 0;
-    virtual const bool ppu_map_write_addr(const uint16_t addr, uint32_t &mapped_addr, const uint8_t data) = 0;
+    // Only for pattern table addresses 0x0000 -> 0x1FFF
+    const uint8_t *chr_read_bank(const uint16_t addr) const {
+        return m_chr_read[addr >> CHR_WINDOW_SHIFT];
+    }
+    uint8_t *chr_write_bank(const uint16_t addr) const {
+        return m_chr_write[addr >> CHR_WINDOW_SHIFT];
+    }
+
+    // Writable RAM windows left read only because a fork still shares the
+    // memory.  The cart takes its own copy on the first write and republishes.
+    const bool prg_write_deferred(const uint16_t addr) const {
+        return (m_prg_write_deferred >> (addr >> PRG_WINDOW_SHIFT)) & 0x01;
+    }
+    const bool chr_write_deferred(const uint16_t addr) const {
+        return (m_chr_write_deferred >> (addr >> CHR_WINDOW_SHIFT)) & 0x01;
+    }
 
 protected:
-    std::shared_ptr<nes::cart::Cart> m_cart;
-    uint8_t m_num_prg_banks;
-    uint8_t m_num_chr_banks;
+    nes::cart::Cart *m_cart; // The cart owns the mapper, so no reference back
+    uint16_t m_num_prg_banks;
+    uint16_t m_num_chr_banks;
+    std::shared_ptr<nes::Scheduler> m_scheduler;
+
+    // Point the size bytes at addr (whole windows) at the bank'th size byte
+    // block of memory.  Banks wrap around and negative banks count back from
+    // the end.  Windows are left unmapped if the cart has no such memory.  RAM
+    // smaller than a window is mirrored across every window it's mapped to.
+    void map_prg_rom(const uint16_t addr, const uint32_t size, const int32_t bank);
+    void map_prg_ram(const uint16_t addr, const uint32_t size, const int32_t bank, const bool writable = true);
+    void unmap_prg(const uint16_t addr, const uint32_t size);
+
+    // CHR-ROM if the cart has any, otherwise CHR-RAM
+    void map_chr(const uint16_t addr, const uint32_t size, const int32_t bank);
+
+    // For mappers that switch the nametable mirroring
+    void set_mirroring(const nes::cart::Mirroring mirroring);
+
+    // clone() for mappers that are plain copyable
+    template <class T>
+    std::shared_ptr<Mapper> clone_as(std::shared_ptr<nes::cart::Cart> cart) const {
+        auto mapper = std::make_shared<T>(static_cast<const T &>(*this));
+        mapper->m_cart = cart.get();
+        return mapper;
+    }
+
+private:
+    const uint8_t *m_prg_read[PRG_NUM_WINDOWS];
+    uint8_t *m_prg_write[PRG_NUM_WINDOWS];
+    uint16_t m_prg_mask[PRG_NUM_WINDOWS];
+    const uint8_t *m_chr_read[CHR_NUM_WINDOWS];
+    uint8_t *m_chr_write[CHR_NUM_WINDOWS];
+    uint8_t m_prg_write_deferred; // Bit per window
+    uint8_t m_chr_write_deferred;
 };
 
 }}} // nes::cart::mapper
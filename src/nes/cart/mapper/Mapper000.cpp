@@ -30,6 +30,7 @@ Links:
 - https://wiki.nesdev.com/w/index.php/NROM
 
 CPU:
+  0x6000 -> 0x7FFF: PRG-RAM if present (Family Basic)
   NROM-128:
 	  0x8000 -> 0xBFFF: Map    0x0000 -> 0x3FFF
 	  0xC000 -> 0xFFFF: Mirror 0x0000 -> 0x3FFF
@@ -43,44 +44,23 @@ PPU:
 #include <cstdint>
 
 #include <nes/cart/mapper/Mapper000.hpp>
+#include <nes/cart/mapper/MapperRegistry.hpp>
 
 namespace nes { namespace cart { namespace mapper {
 
-void Mapper000::reset() {
-    // Nothing to do on reset
-}
-
-const bool Mapper000::cpu_map_read_addr(const uint16_t addr, uint32_t &mapped_addr) {
-    if (addr >= ADDR_PRG_ROM_BEGIN && addr <= ADDR_PRG_ROM_END) {
-        mapped_addr = addr & (m_variation == NROM_256 ? 0x7FFF : 0x3FFF);
-        return true;
-    }
-
-    return false;
-}
+static MapperRegistry::Registrar s_registrar(0, &MapperRegistry::make<Mapper000>);
 
-const bool Mapper000::cpu_map_write_addr(const uint16_t addr, uint32_t &mapped_addr, const uint8_t data) {
-    // Write mapping is the same as read
-    return cpu_map_read_addr(addr, mapped_addr);
-}
-
-const bool Mapper000::ppu_map_read_addr(const uint16_t addr, uint32_t &mapped_addr) {
-    if (addr >= ADDR_CHR_ROM_BEGIN && addr <= ADDR_CHR_ROM_END) {
-        mapped_addr = addr;
-        return true;
-    }
-
-    return false;
+void Mapper000::reset() {
+    // No registers, the banks never move
+    update_banks();
 }
 
-const bool Mapper000::ppu_map_write_addr(const uint16_t addr, uint32_t &mapped_addr, const uint8_t data) {
-    // Only map if CHR is RAM
-    if (m_num_chr_banks == 0) {
-        // Write mapping is the same as read
-        return ppu_map_read_addr(addr, mapped_addr);
-    }
-
-    return false;
+void Mapper000::update_banks() {
+    map_prg_ram(ADDR_PRG_RAM_BEGIN, PRG_RAM_SIZE, 0);
+    // The last bank is the first bank on NROM-128
+    map_prg_rom(ADDR_PRG_ROM_LOW_BEGIN, PRG_ROM_BANK_SIZE, 0);
+    map_prg_rom(ADDR_PRG_ROM_HIGH_BEGIN, PRG_ROM_BANK_SIZE, -1);
+    map_chr(0x0000, CHR_BANK_SIZE, 0);
 }
 
 }}} // nes::cart::mapper
\ No newline at end of file
@@ -41,30 +41,24 @@ namespace nes { namespace cart { namespace mapper {
 
 class Mapper000 : public Mapper {
 public:
-    Mapper000(std::shared_ptr<nes::cart::Cart> cart, uint8_t num_prg_banks, uint8_t num_chr_banks)
+    Mapper000(std::shared_ptr<nes::cart::Cart> cart, uint16_t num_prg_banks, uint16_t num_chr_banks)
         : Mapper(cart, num_prg_banks, num_chr_banks) {
-        m_variation = num_prg_banks > 1 ? NROM_256 : NROM_128;
     }
 
     void reset() override;
+    void update_banks() override;
 
-    // Map addresses in CPU read/write address space
-    const bool cpu_map_read_addr(const uint16_t addr, uint32_t &mapped_addr) override;
-    const bool cpu_map_write_addr(const uint16_t addr, uint32_t &mapped_addr, const uint8_t data) override;
-
-    // Map addresses in PPU read/write address space
-    const bool ppu_map_read_addr(const uint16_t addr, uint32_t &mapped_addr) override;
-    const bool ppu_map_write_addr(const uint16_t addr, uint32_t &mapped_addr, const uint8_t data) override;
+    std::shared_ptr<Mapper> clone(std::shared_ptr<nes::cart::Cart> cart) const override {
+        return clone_as<Mapper000>(cart);
+    }
 
 private:
-    static const uint16_t ADDR_PRG_ROM_BEGIN = 0x8000; static const uint16_t ADDR_PRG_ROM_END = 0xFFFF;
-    static const uint16_t ADDR_CHR_ROM_BEGIN = 0x0000; static const uint16_t ADDR_CHR_ROM_END = 0x1FFF;
-
-    enum Variation {
-        NROM_128,
-        NROM_256
-    } m_variation;
-
+    static const uint16_t ADDR_PRG_RAM_BEGIN = 0x6000;
+    static const uint16_t ADDR_PRG_ROM_LOW_BEGIN = 0x8000;
+    static const uint16_t ADDR_PRG_ROM_HIGH_BEGIN = 0xC000;
+    static const uint32_t PRG_RAM_SIZE = 8 * 1024;
+    static const uint32_t PRG_ROM_BANK_SIZE = 16 * 1024;
+    static const uint32_t CHR_BANK_SIZE = 8 * 1024;
 };
 
 }}} // nes::cart::mapper
\ No newline at end of file
@@ -0,0 +1,187 @@
+/*******************************************************************************
+MIT License
+
+Copyright (c) 2020 Chris Luby
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+/*******************************************************************************
+Emulation of the Mapper 001 / MMC1 chip on some of the the Nintendo Entertainment
+System Cartriges
+
+Links:
+- https://wiki.nesdev.com/w/index.php/MMC1
+
+Registers are loaded one bit at a time through a 5 bit shift register, writing
+the value to 0x8000 -> 0xFFFF.  The fifth write picks the register by address:
+  0x8000 -> 0x9FFF: Control (mirroring, PRG mode, CHR mode)
+  0xA000 -> 0xBFFF: CHR bank 0
+  0xC000 -> 0xDFFF: CHR bank 1
+  0xE000 -> 0xFFFF: PRG bank (and PRG-RAM disable)
+Writing a value with bit 7 set resets the shift register.
+
+CPU:
+  0x6000 -> 0x7FFF: 8KB PRG-RAM when enabled
+  0x8000 -> 0xBFFF: 16KB switchable or fixed to the first bank
+  0xC000 -> 0xFFFF: 16KB switchable or fixed to the last bank
+  (or 32KB switchable at 0x8000 -> 0xFFFF)
+
+PPU:
+  0x0000 -> 0x0FFF: 4KB switchable
+  0x1000 -> 0x1FFF: 4KB switchable
+  (or 8KB switchable at 0x0000 -> 0x1FFF)
+*******************************************************************************/
+
+#include <cstdint>
+
+#include <nes/cart/mapper/Mapper001.hpp>
+#include <nes/cart/mapper/MapperRegistry.hpp>
+
+namespace nes { namespace cart { namespace mapper {
+
+static MapperRegistry::Registrar s_registrar(1, &MapperRegistry::make<Mapper001>);
+
+void Mapper001::reset() {
+    m_shift = 0x00;
+    m_shift_count = 0;
+    m_last_write_cycle = nes::Scheduler::NEVER;
+
+    m_control = CONTROL_POWER_ON;
+    m_chr_bank_0 = 0x00;
+    m_chr_bank_1 = 0x00;
+    m_prg_bank = 0x00;
+
+    update_banks();
+}
+
+void Mapper001::update_banks() {
+    static const nes::cart::Mirroring MIRRORING[4] = {
+        nes::cart::MIRROR_SINGLE_SCREEN_LOW,
+        nes::cart::MIRROR_SINGLE_SCREEN_HIGH,
+        nes::cart::MIRROR_VERTICAL,
+        nes::cart::MIRROR_HORIZONTAL
+    };
+    set_mirroring(MIRRORING[m_control & 0x03]);
+
+    // Bit 4 of the PRG bank disables PRG-RAM
+    if ((m_prg_bank & 0x10) == 0) {
+        map_prg_ram(ADDR_PRG_RAM_BEGIN, PRG_RAM_SIZE, 0);
+    } else {
+        unmap_prg(ADDR_PRG_RAM_BEGIN, PRG_RAM_SIZE);
+    }
+
+    const int32_t outer = m_num_prg_banks > PRG_BANKS_PER_OUTER_BANK ? (m_chr_bank_0 & 0x10) : 0;
+    const int32_t bank = outer | (m_prg_bank & 0x0F);
+    switch ((m_control >> 2) & 0x03) {
+        case PRG_MODE_32K_0:
+        case PRG_MODE_32K_1:
+            // The low bit of the bank number is ignored
+            map_prg_rom(ADDR_PRG_ROM_BEGIN, PRG_BANK_SIZE, bank & ~1);
+            map_prg_rom(ADDR_PRG_ROM_HIGH_BEGIN, PRG_BANK_SIZE, bank | 1);
+            break;
+        case PRG_MODE_FIX_FIRST:
+            map_prg_rom(ADDR_PRG_ROM_BEGIN, PRG_BANK_SIZE, outer);
+            map_prg_rom(ADDR_PRG_ROM_HIGH_BEGIN, PRG_BANK_SIZE, bank);
+            break;
+        case PRG_MODE_FIX_LAST:
+            map_prg_rom(ADDR_PRG_ROM_BEGIN, PRG_BANK_SIZE, bank);
+            map_prg_rom(ADDR_PRG_ROM_HIGH_BEGIN, PRG_BANK_SIZE, outer | (PRG_BANKS_PER_OUTER_BANK - 1));
+            break;
+    }
+
+    if (m_control & 0x10) {
+        // Two 4KB banks
+        map_chr(0x0000, CHR_BANK_SIZE, m_chr_bank_0);
+        map_chr(0x1000, CHR_BANK_SIZE, m_chr_bank_1);
+    } else {
+        // One 8KB bank, the low bit of the bank number is ignored
+        map_chr(0x0000, CHR_BANK_SIZE, m_chr_bank_0 & ~1);
+        map_chr(0x1000, CHR_BANK_SIZE, m_chr_bank_0 | 1);
+    }
+}
+
+/**
+ * Only the fifth write of a sequence touches the registers and banks.  Writes
+ * on the cycle right after another (the double write of read-modify-write
+ * instructions) are ignored by the chip.
+ */
+const bool Mapper001::cpu_write(const uint16_t addr, const uint8_t data) {
+    if (addr < ADDR_PRG_ROM_BEGIN) {
+        return false;
+    }
+
+    // The CPU makes all of an instruction's accesses on its first cycle, so both
+    // writes of a read-modify-write can land on the same scheduler cycle
+    const uint64_t cycle = m_scheduler != nullptr ? m_scheduler->now() : nes::Scheduler::NEVER;
+    const bool consecutive = cycle != nes::Scheduler::NEVER && m_last_write_cycle != nes::Scheduler::NEVER && cycle - m_last_write_cycle <= 1;
+    m_last_write_cycle = cycle;
+    if (consecutive) {
+        return true;
+    }
+
+    if (data & SHIFT_RESET) {
+        m_shift = 0x00;
+        m_shift_count = 0;
+        m_control |= CONTROL_POWER_ON;
+        update_banks();
+        return true;
+    }
+
+    m_shift = (m_shift >> 1) | ((data & 0x01) << 4);
+    m_shift_count++;
+    if (m_shift_count < SHIFT_WRITES) {
+        return true;
+    }
+
+    switch ((addr >> 13) & 0x03) {
+        case 0: m_control = m_shift; break;
+        case 1: m_chr_bank_0 = m_shift; break;
+        case 2: m_chr_bank_1 = m_shift; break;
+        case 3: m_prg_bank = m_shift; break;
+    }
+    m_shift = 0x00;
+    m_shift_count = 0;
+
+    update_banks();
+    return true;
+}
+
+void Mapper001::save_state(StateWriter &state) const {
+    state.begin("MMC1");
+    state.write(m_shift);
+    state.write(m_shift_count);
+    state.write(m_last_write_cycle);
+    state.write(m_control);
+    state.write(m_chr_bank_0);
+    state.write(m_chr_bank_1);
+    state.write(m_prg_bank);
+}
+
+void Mapper001::load_state(StateReader &state) {
+    state.begin("MMC1");
+    state.read(m_shift);
+    state.read(m_shift_count);
+    state.read(m_last_write_cycle);
+    state.read(m_control);
+    state.read(m_chr_bank_0);
+    state.read(m_chr_bank_1);
+    state.read(m_prg_bank);
+}
+
+}}} // nes::cart::mapper
\ No newline at end of file
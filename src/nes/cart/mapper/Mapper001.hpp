@@ -0,0 +1,110 @@
+/*******************************************************************************
+MIT License
+
+Copyright (c) 2020 Chris Luby
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+/*******************************************************************************
+Emulation of the Mapper 001 / MMC1 chip on some of the the Nintendo Entertainment
+System Cartriges
+
+Links:
+- https://wiki.nesdev.com/w/index.php/MMC1
+
+Registers are loaded one bit at a time through a 5 bit shift register, writing
+the value to 0x8000 -> 0xFFFF.  The fifth write picks the register by address:
+  0x8000 -> 0x9FFF: Control (mirroring, PRG mode, CHR mode)
+  0xA000 -> 0xBFFF: CHR bank 0
+  0xC000 -> 0xDFFF: CHR bank 1
+  0xE000 -> 0xFFFF: PRG bank (and PRG-RAM disable)
+Writing a value with bit 7 set resets the shift register.
+
+CPU:
+  0x6000 -> 0x7FFF: 8KB PRG-RAM when enabled
+  0x8000 -> 0xBFFF: 16KB switchable or fixed to the first bank
+  0xC000 -> 0xFFFF: 16KB switchable or fixed to the last bank
+  (or 32KB switchable at 0x8000 -> 0xFFFF)
+
+PPU:
+  0x0000 -> 0x0FFF: 4KB switchable
+  0x1000 -> 0x1FFF: 4KB switchable
+  (or 8KB switchable at 0x0000 -> 0x1FFF)
+*******************************************************************************/
+
+#pragma once
+
+#include <memory>
+#include <cstdint>
+
+#include <nes/cart/mapper/Mapper.hpp>
+
+namespace nes { namespace cart { namespace mapper {
+
+class Mapper001 : public Mapper {
+public:
+    Mapper001(std::shared_ptr<nes::cart::Cart> cart, uint16_t num_prg_banks, uint16_t num_chr_banks)
+        : Mapper(cart, num_prg_banks, num_chr_banks) {
+    }
+
+    void reset() override;
+    void update_banks() override;
+
+    std::shared_ptr<Mapper> clone(std::shared_ptr<nes::cart::Cart> cart) const override {
+        return clone_as<Mapper001>(cart);
+    }
+
+    void save_state(StateWriter &state) const override;
+    void load_state(StateReader &state) override;
+
+    const bool cpu_write(const uint16_t addr, const uint8_t data) override;
+
+private:
+    static const uint16_t ADDR_PRG_RAM_BEGIN = 0x6000;
+    static const uint16_t ADDR_PRG_ROM_BEGIN = 0x8000;
+    static const uint16_t ADDR_PRG_ROM_HIGH_BEGIN = 0xC000;
+    static const uint32_t PRG_RAM_SIZE = 8 * 1024;
+    static const uint32_t PRG_BANK_SIZE = 16 * 1024;
+    static const uint32_t CHR_BANK_SIZE = 4 * 1024;
+
+    // PRG is banked within 256KB, larger boards (SUROM) pick the half with CHR bank bit 4
+    static const uint16_t PRG_BANKS_PER_OUTER_BANK = 16;
+
+    static const uint8_t SHIFT_RESET = 0x80;
+    static const uint8_t SHIFT_WRITES = 5;
+    static const uint8_t CONTROL_POWER_ON = 0x0C;
+
+    enum PrgMode {
+        PRG_MODE_32K_0 = 0,
+        PRG_MODE_32K_1 = 1,
+        PRG_MODE_FIX_FIRST = 2,
+        PRG_MODE_FIX_LAST = 3
+    };
+
+    uint8_t m_shift;
+    uint8_t m_shift_count;
+    uint64_t m_last_write_cycle;
+
+    uint8_t m_control;
+    uint8_t m_chr_bank_0;
+    uint8_t m_chr_bank_1;
+    uint8_t m_prg_bank;
+};
+
+}}} // nes::cart::mapper
@@ -0,0 +1,219 @@
+/*******************************************************************************
+MIT License
+
+Copyright (c) 2020 Chris Luby
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+/*******************************************************************************
+Emulation of the Mapper 004 / MMC3 chip on some of the the Nintendo Entertainment
+System Cartriges
+
+Links:
+- https://wiki.nesdev.com/w/index.php/MMC3
+
+Registers (even / odd addresses):
+  0x8000 -> 0x9FFF: Bank select / bank data
+  0xA000 -> 0xBFFF: Mirroring / PRG-RAM protect
+  0xC000 -> 0xDFFF: IRQ latch / IRQ reload
+  0xE000 -> 0xFFFF: IRQ disable / IRQ enable
+
+CPU:
+  0x6000 -> 0x7FFF: 8KB PRG-RAM
+  0x8000 -> 0x9FFF: 8KB switchable (R6) or fixed to the second last bank
+  0xA000 -> 0xBFFF: 8KB switchable (R7)
+  0xC000 -> 0xDFFF: 8KB fixed to the second last bank or switchable (R6)
+  0xE000 -> 0xFFFF: 8KB fixed to the last bank
+
+PPU:
+  0x0000 -> 0x0FFF: Two 2KB switchable (R0, R1) or four 1KB switchable (R2 - R5)
+  0x1000 -> 0x1FFF: Four 1KB switchable (R2 - R5) or two 2KB switchable (R0, R1)
+
+The scanline counter is clocked by rising edges of PPU A12, once per rendering
+scanline with the usual pattern table setup.  The bus counts those edges and
+schedules the IRQ, see Bus::schedule_mapper_irq().
+*******************************************************************************/
+
+#include <algorithm>
+#include <cstdint>
+
+#include <nes/cart/mapper/Mapper004.hpp>
+#include <nes/cart/mapper/MapperRegistry.hpp>
+#include <nes/cart/Cart.hpp>
+
+namespace nes { namespace cart { namespace mapper {
+
+static MapperRegistry::Registrar s_registrar(4, &MapperRegistry::make<Mapper004>);
+
+void Mapper004::reset() {
+    m_bank_select = 0x00;
+    const uint8_t banks[8] = { 0, 2, 4, 5, 6, 7, 0, 1 };
+    std::copy(banks, banks + 8, m_banks);
+    m_mirroring = 0x00;
+    m_prg_ram_protect = PRG_RAM_ENABLE;
+    // Boards wired for four screen ignore the mirroring register
+    m_four_screen = m_cart->mirroring() == nes::cart::MIRROR_FOUR_SCREEN;
+
+    m_irq_latch = 0x00;
+    m_irq_counter = 0x00;
+    m_irq_reload = false;
+    m_irq_enabled = false;
+    m_irq = false;
+
+    update_banks();
+}
+
+void Mapper004::update_banks() {
+    if (!m_four_screen) {
+        set_mirroring(m_mirroring & 0x01 ? nes::cart::MIRROR_HORIZONTAL : nes::cart::MIRROR_VERTICAL);
+    }
+
+    if (m_prg_ram_protect & PRG_RAM_ENABLE) {
+        map_prg_ram(ADDR_PRG_RAM_BEGIN, PRG_RAM_SIZE, 0, (m_prg_ram_protect & PRG_RAM_WRITE_PROTECT) == 0);
+    } else {
+        unmap_prg(ADDR_PRG_RAM_BEGIN, PRG_RAM_SIZE);
+    }
+
+    // R6 and the second last bank swap places in PRG mode 1
+    const bool prg_mode = (m_bank_select & BANK_SELECT_PRG_MODE) != 0;
+    map_prg_rom(0x8000, PRG_BANK_SIZE, prg_mode ? -2 : m_banks[6] & 0x3F);
+    map_prg_rom(0xA000, PRG_BANK_SIZE, m_banks[7] & 0x3F);
+    map_prg_rom(0xC000, PRG_BANK_SIZE, prg_mode ? m_banks[6] & 0x3F : -2);
+    map_prg_rom(0xE000, PRG_BANK_SIZE, -1);
+
+    // The 2KB and 1KB halves swap places with CHR inversion
+    const uint16_t chr_2k = (m_bank_select & BANK_SELECT_CHR_INVERSION) ? 0x1000 : 0x0000;
+    const uint16_t chr_1k = chr_2k ^ 0x1000;
+    map_chr(chr_2k, 2 * CHR_BANK_SIZE, m_banks[0] >> 1);
+    map_chr(chr_2k + 0x0800, 2 * CHR_BANK_SIZE, m_banks[1] >> 1);
+    map_chr(chr_1k, CHR_BANK_SIZE, m_banks[2]);
+    map_chr(chr_1k + 0x0400, CHR_BANK_SIZE, m_banks[3]);
+    map_chr(chr_1k + 0x0800, CHR_BANK_SIZE, m_banks[4]);
+    map_chr(chr_1k + 0x0C00, CHR_BANK_SIZE, m_banks[5]);
+}
+
+const bool Mapper004::cpu_write(const uint16_t addr, const uint8_t data) {
+    if (addr < ADDR_PRG_ROM_BEGIN) {
+        return false;
+    }
+
+    const bool odd = (addr & 0x0001) != 0;
+    switch ((addr >> 13) & 0x03) {
+        case 0:
+            if (odd) {
+                m_banks[m_bank_select & 0x07] = data;
+            } else {
+                m_bank_select = data;
+            }
+            update_banks();
+            break;
+        case 1:
+            if (odd) {
+                m_prg_ram_protect = data;
+            } else {
+                m_mirroring = data;
+            }
+            update_banks();
+            break;
+        case 2:
+            if (odd) {
+                // Reloaded from the latch on the next clock
+                m_irq_counter = 0;
+                m_irq_reload = true;
+            } else {
+                m_irq_latch = data;
+            }
+            break;
+        case 3:
+            m_irq_enabled = odd;
+            if (!odd) {
+                // Disabling also acknowledges
+                m_irq = false;
+            }
+            break;
+    }
+
+    return true;
+}
+
+/**
+ * Apply count A12 clocks at once.  Runs of plain decrements are taken in one
+ * step so a long gap between syncs costs about one loop per IRQ period.
+ */
+void Mapper004::clock_scanline_counter(uint32_t count) {
+    while (count > 0) {
+        if (m_irq_counter == 0 || m_irq_reload) {
+            m_irq_counter = m_irq_latch;
+            m_irq_reload = false;
+            count--;
+        } else {
+            const uint32_t steps = std::min<uint32_t>(count, m_irq_counter);
+            m_irq_counter -= steps;
+            count -= steps;
+        }
+
+        if (m_irq_counter == 0) {
+            if (m_irq_enabled) {
+                m_irq = true;
+            }
+            // With a latch of 0 every further clock leaves the counter at 0
+            if (m_irq_latch == 0) {
+                break;
+            }
+        }
+    }
+}
+
+const uint32_t Mapper004::scanline_clocks_until_irq() const {
+    if (!m_irq_enabled || m_irq) {
+        return NO_SCANLINE_IRQ;
+    }
+    if (m_irq_counter == 0 || m_irq_reload) {
+        return (uint32_t)m_irq_latch + 1;
+    }
+    return m_irq_counter;
+}
+
+void Mapper004::save_state(StateWriter &state) const {
+    state.begin("MMC3");
+    state.write(m_bank_select);
+    state.write(m_banks);
+    state.write(m_mirroring);
+    state.write(m_prg_ram_protect);
+    state.write(m_irq_latch);
+    state.write(m_irq_counter);
+    state.write(m_irq_reload);
+    state.write(m_irq_enabled);
+    state.write(m_irq);
+}
+
+void Mapper004::load_state(StateReader &state) {
+    state.begin("MMC3");
+    state.read(m_bank_select);
+    state.read(m_banks);
+    state.read(m_mirroring);
+    state.read(m_prg_ram_protect);
+    state.read(m_irq_latch);
+    state.read(m_irq_counter);
+    state.read(m_irq_reload);
+    state.read(m_irq_enabled);
+    state.read(m_irq);
+}
+
+}}} // nes::cart::mapper
\ No newline at end of file
@@ -0,0 +1,115 @@
+/*******************************************************************************
+MIT License
+
+Copyright (c) 2020 Chris Luby
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+/*******************************************************************************
+Emulation of the Mapper 004 / MMC3 chip on some of the the Nintendo Entertainment
+System Cartriges
+
+Links:
+- https://wiki.nesdev.com/w/index.php/MMC3
+
+Registers (even / odd addresses):
+  0x8000 -> 0x9FFF: Bank select / bank data
+  0xA000 -> 0xBFFF: Mirroring / PRG-RAM protect
+  0xC000 -> 0xDFFF: IRQ latch / IRQ reload
+  0xE000 -> 0xFFFF: IRQ disable / IRQ enable
+
+CPU:
+  0x6000 -> 0x7FFF: 8KB PRG-RAM
+  0x8000 -> 0x9FFF: 8KB switchable (R6) or fixed to the second last bank
+  0xA000 -> 0xBFFF: 8KB switchable (R7)
+  0xC000 -> 0xDFFF: 8KB fixed to the second last bank or switchable (R6)
+  0xE000 -> 0xFFFF: 8KB fixed to the last bank
+
+PPU:
+  0x0000 -> 0x0FFF: Two 2KB switchable (R0, R1) or four 1KB switchable (R2 - R5)
+  0x1000 -> 0x1FFF: Four 1KB switchable (R2 - R5) or two 2KB switchable (R0, R1)
+
+The scanline counter is clocked by rising edges of PPU A12, once per rendering
+scanline with the usual pattern table setup.  The bus counts those edges and
+schedules the IRQ, see Bus::schedule_mapper_irq().
+*******************************************************************************/
+
+#pragma once
+
+#include <memory>
+#include <cstdint>
+
+#include <nes/cart/mapper/Mapper.hpp>
+
+namespace nes { namespace cart { namespace mapper {
+
+class Mapper004 : public Mapper {
+public:
+    Mapper004(std::shared_ptr<nes::cart::Cart> cart, uint16_t num_prg_banks, uint16_t num_chr_banks)
+        : Mapper(cart, num_prg_banks, num_chr_banks) {
+    }
+
+    void reset() override;
+    void update_banks() override;
+
+    std::shared_ptr<Mapper> clone(std::shared_ptr<nes::cart::Cart> cart) const override {
+        return clone_as<Mapper004>(cart);
+    }
+
+    void save_state(StateWriter &state) const override;
+    void load_state(StateReader &state) override;
+
+    const bool cpu_write(const uint16_t addr, const uint8_t data) override;
+
+    const bool irq() const override {
+        return m_irq;
+    }
+
+    const bool scanline_counter() const override {
+        return true;
+    }
+    void clock_scanline_counter(uint32_t count) override;
+    const uint32_t scanline_clocks_until_irq() const override;
+
+private:
+    static const uint16_t ADDR_PRG_RAM_BEGIN = 0x6000;
+    static const uint16_t ADDR_PRG_ROM_BEGIN = 0x8000;
+    static const uint32_t PRG_RAM_SIZE = 8 * 1024;
+    static const uint32_t PRG_BANK_SIZE = 8 * 1024;
+    static const uint32_t CHR_BANK_SIZE = 1024;
+
+    static const uint8_t BANK_SELECT_PRG_MODE = 0x40;
+    static const uint8_t BANK_SELECT_CHR_INVERSION = 0x80;
+    static const uint8_t PRG_RAM_ENABLE = 0x80;
+    static const uint8_t PRG_RAM_WRITE_PROTECT = 0x40;
+
+    uint8_t m_bank_select;
+    uint8_t m_banks[8]; // R0 - R7
+    uint8_t m_mirroring;
+    uint8_t m_prg_ram_protect;
+    bool m_four_screen;
+
+    uint8_t m_irq_latch;
+    uint8_t m_irq_counter;
+    bool m_irq_reload;
+    bool m_irq_enabled;
+    bool m_irq;
+};
+
+}}} // nes::cart::mapper
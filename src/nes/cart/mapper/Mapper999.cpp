@@ -36,46 +36,31 @@ PPU:
 #include <cstdint>
 
 #include <nes/cart/mapper/Mapper999.hpp>
+#include <nes/cart/mapper/MapperRegistry.hpp>
 #include <nes/cart/Cart.hpp>
 
 namespace nes { namespace cart { namespace mapper {
 
+static MapperRegistry::Registrar s_registrar(999, &MapperRegistry::make<Mapper999>);
+
 void Mapper999::reset() {
-    // Nothing to do on reset
+    update_banks();
 }
 
-const bool Mapper999::cpu_map_read_addr(const uint16_t addr, uint32_t &mapped_addr) {
-    if (addr >= ADDR_PRG_ROM_BEGIN && addr <= ADDR_PRG_ROM_END) {
-        mapped_addr = addr & 0x7FFF;
-        return true;
-    }
-
-    return false;
+void Mapper999::update_banks() {
+    map_prg_rom(ADDR_PRG_ROM_BEGIN, PRG_ROM_SIZE, 0);
+    map_chr(0x0000, CHR_SIZE, 0);
 }
 
-const bool Mapper999::cpu_map_write_addr(const uint16_t addr, uint32_t &mapped_addr, const uint8_t data) {
+const bool Mapper999::cpu_write(const uint16_t addr, const uint8_t data) {
     // If the write is going to the special character printing address,
     // write the data out as a single character to stdout and flush.
     if (addr == ADDR_PRG_PRINT_CHAR) {
-        mapped_addr = addr;
         std::cout << (char)data << std::flush;
         return true;
     }
 
-    return cpu_map_read_addr(addr, mapped_addr);
-}
-
-const bool Mapper999::ppu_map_read_addr(const uint16_t addr, uint32_t &mapped_addr) {
-    if (addr >= ADDR_CHR_ROM_BEGIN && addr <= ADDR_CHR_ROM_END) {
-        mapped_addr = addr;
-        return true;
-    }
-
     return false;
 }
 
-const bool Mapper999::ppu_map_write_addr(const uint16_t addr, uint32_t &mapped_addr, const uint8_t data) {
-    return ppu_map_read_addr(addr, mapped_addr);
-}
-
 }}} // nes::cart::mapper
\ No newline at end of file
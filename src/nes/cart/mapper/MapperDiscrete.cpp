@@ -0,0 +1,53 @@
+/*******************************************************************************
+MIT License
+
+Copyright (c) 2020 Chris Luby
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+/*******************************************************************************
+Registers the discrete logic boards, see MapperDiscrete.hpp.  NES 2.0 sub
+mappers say whether the board has bus conflicts (1 = no, 2 = yes), otherwise
+the board's usual behavior is used.
+*******************************************************************************/
+
+#include <memory>
+#include <cstdint>
+
+#include <nes/cart/mapper/MapperDiscrete.hpp>
+#include <nes/cart/mapper/MapperRegistry.hpp>
+
+namespace nes { namespace cart { namespace mapper {
+
+template <class Board>
+static std::shared_ptr<Mapper> make_discrete(std::shared_ptr<nes::cart::Cart> cart, uint16_t num_prg_banks, uint16_t num_chr_banks, uint8_t sub_mapper_id) {
+    switch (sub_mapper_id) {
+        case 1: return std::make_shared<MapperDiscrete<Board, false>>(cart, num_prg_banks, num_chr_banks);
+        case 2: return std::make_shared<MapperDiscrete<Board, true>>(cart, num_prg_banks, num_chr_banks);
+        default: return std::make_shared<MapperDiscrete<Board>>(cart, num_prg_banks, num_chr_banks);
+    }
+}
+
+static MapperRegistry::Registrar s_registrar_002(2, &make_discrete<UxROM>);
+static MapperRegistry::Registrar s_registrar_003(3, &make_discrete<CNROM>);
+static MapperRegistry::Registrar s_registrar_007(7, &make_discrete<AxROM>);
+static MapperRegistry::Registrar s_registrar_066(66, &MapperRegistry::make<Mapper066>);
+
+}}} // nes::cart::mapper
@@ -0,0 +1,185 @@
+/*******************************************************************************
+MIT License
+
+Copyright (c) 2020 Chris Luby
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+/*******************************************************************************
+Emulation of the discrete logic boards on some of the the Nintendo Entertainment
+System Cartriges.  A latch on 0x8000 -> 0xFFFF holds a single register and the
+boards only differ in which of its bits select the banks, so each one is a
+specialization of MapperDiscrete over a board description.
+
+Links:
+- https://wiki.nesdev.com/w/index.php/UxROM
+- https://wiki.nesdev.com/w/index.php/CNROM
+- https://wiki.nesdev.com/w/index.php/AxROM
+- https://wiki.nesdev.com/w/index.php/GxROM
+- https://wiki.nesdev.com/w/index.php/Bus_conflict
+
+Mapper 002 / UxROM:
+  0x8000 -> 0xBFFF: 16KB switchable (bits 0 - 7)
+  0xC000 -> 0xFFFF: 16KB fixed to the last bank
+  PPU: 8KB CHR-RAM
+
+Mapper 003 / CNROM:
+  0x8000 -> 0xFFFF: 32KB fixed (or 16KB mirrored)
+  PPU: 8KB switchable (bits 0 - 7)
+
+Mapper 007 / AxROM:
+  0x8000 -> 0xFFFF: 32KB switchable (bits 0 - 2)
+  PPU: 8KB CHR-RAM, single screen mirroring picked by bit 4
+
+Mapper 066 / GxROM:
+  0x8000 -> 0xFFFF: 32KB switchable (bits 4 - 5)
+  PPU: 8KB switchable (bits 0 - 1)
+
+On boards with bus conflicts the ROM drives the data bus during the write as
+well, so the latch sees the written value ANDed with the ROM byte underneath.
+*******************************************************************************/
+
+#pragma once
+
+#include <memory>
+#include <cstdint>
+
+#include <nes/cart/mapper/Mapper.hpp>
+
+namespace nes { namespace cart { namespace mapper {
+
+// Board descriptions, a zero mask means the latch doesn't switch that part
+struct UxROM {
+    static const uint32_t PRG_BANK_SIZE = 16 * 1024;
+    static const uint8_t PRG_SELECT_MASK = 0xFF; static const uint8_t PRG_SELECT_SHIFT = 0;
+    static const bool PRG_FIXED_LAST = true;
+    static const uint8_t CHR_SELECT_MASK = 0x00; static const uint8_t CHR_SELECT_SHIFT = 0;
+    static const uint8_t MIRROR_SELECT_MASK = 0x00;
+    static const bool BUS_CONFLICTS = true;
+};
+
+struct CNROM {
+    static const uint32_t PRG_BANK_SIZE = 32 * 1024;
+    static const uint8_t PRG_SELECT_MASK = 0x00; static const uint8_t PRG_SELECT_SHIFT = 0;
+    static const bool PRG_FIXED_LAST = false;
+    static const uint8_t CHR_SELECT_MASK = 0xFF; static const uint8_t CHR_SELECT_SHIFT = 0;
+    static const uint8_t MIRROR_SELECT_MASK = 0x00;
+    static const bool BUS_CONFLICTS = true;
+};
+
+struct AxROM {
+    static const uint32_t PRG_BANK_SIZE = 32 * 1024;
+    static const uint8_t PRG_SELECT_MASK = 0x07; static const uint8_t PRG_SELECT_SHIFT = 0;
+    static const bool PRG_FIXED_LAST = false;
+    static const uint8_t CHR_SELECT_MASK = 0x00; static const uint8_t CHR_SELECT_SHIFT = 0;
+    static const uint8_t MIRROR_SELECT_MASK = 0x10;
+    static const bool BUS_CONFLICTS = false;
+};
+
+struct GxROM {
+    static const uint32_t PRG_BANK_SIZE = 32 * 1024;
+    static const uint8_t PRG_SELECT_MASK = 0x30; static const uint8_t PRG_SELECT_SHIFT = 4;
+    static const bool PRG_FIXED_LAST = false;
+    static const uint8_t CHR_SELECT_MASK = 0x03; static const uint8_t CHR_SELECT_SHIFT = 0;
+    static const uint8_t MIRROR_SELECT_MASK = 0x00;
+    static const bool BUS_CONFLICTS = true;
+};
+
+template <typename Board, bool BUS_CONFLICTS = Board::BUS_CONFLICTS>
+class MapperDiscrete : public Mapper {
+public:
+    MapperDiscrete(std::shared_ptr<nes::cart::Cart> cart, uint16_t num_prg_banks, uint16_t num_chr_banks)
+        : Mapper(cart, num_prg_banks, num_chr_banks) {
+    }
+
+    void reset() override {
+        m_latch = 0x00;
+        update_banks();
+    }
+
+    void update_banks() override {
+        map_prg_ram(ADDR_PRG_RAM_BEGIN, PRG_RAM_SIZE, 0);
+
+        // Boards without a PRG select still mirror NROM-128 sized ROMs
+        const uint8_t prg_bank = (m_latch & Board::PRG_SELECT_MASK) >> Board::PRG_SELECT_SHIFT;
+        if (Board::PRG_BANK_SIZE == PRG_ROM_BANK_SIZE && Board::PRG_FIXED_LAST) {
+            map_prg_rom(ADDR_PRG_ROM_LOW_BEGIN, PRG_ROM_BANK_SIZE, prg_bank);
+            map_prg_rom(ADDR_PRG_ROM_HIGH_BEGIN, PRG_ROM_BANK_SIZE, -1);
+        } else if (m_num_prg_banks < 2) {
+            map_prg_rom(ADDR_PRG_ROM_LOW_BEGIN, PRG_ROM_BANK_SIZE, 0);
+            map_prg_rom(ADDR_PRG_ROM_HIGH_BEGIN, PRG_ROM_BANK_SIZE, 0);
+        } else {
+            map_prg_rom(ADDR_PRG_ROM_LOW_BEGIN, Board::PRG_BANK_SIZE, prg_bank);
+        }
+
+        map_chr(0x0000, CHR_BANK_SIZE, (m_latch & Board::CHR_SELECT_MASK) >> Board::CHR_SELECT_SHIFT);
+
+        if (Board::MIRROR_SELECT_MASK != 0x00) {
+            set_mirroring(m_latch & Board::MIRROR_SELECT_MASK ? nes::cart::MIRROR_SINGLE_SCREEN_HIGH : nes::cart::MIRROR_SINGLE_SCREEN_LOW);
+        }
+    }
+
+    std::shared_ptr<Mapper> clone(std::shared_ptr<nes::cart::Cart> cart) const override {
+        return clone_as<MapperDiscrete>(cart);
+    }
+
+    const bool cpu_write(const uint16_t addr, const uint8_t data) override {
+        if (addr < ADDR_PRG_ROM_LOW_BEGIN) {
+            return false;
+        }
+
+        m_latch = data;
+        if (BUS_CONFLICTS) {
+            const uint8_t *bank = prg_read_bank(addr);
+            if (bank != nullptr) {
+                m_latch &= bank[addr & PRG_WINDOW_MASK];
+            }
+        }
+        update_banks();
+        return true;
+    }
+
+    void save_state(StateWriter &state) const override {
+        state.begin("LTCH");
+        state.write(m_latch);
+    }
+
+    void load_state(StateReader &state) override {
+        state.begin("LTCH");
+        state.read(m_latch);
+    }
+
+private:
+    static const uint16_t ADDR_PRG_RAM_BEGIN = 0x6000;
+    static const uint16_t ADDR_PRG_ROM_LOW_BEGIN = 0x8000;
+    static const uint16_t ADDR_PRG_ROM_HIGH_BEGIN = 0xC000;
+    static const uint32_t PRG_RAM_SIZE = 8 * 1024;
+    static const uint32_t PRG_ROM_BANK_SIZE = 16 * 1024;
+    static const uint32_t CHR_BANK_SIZE = 8 * 1024;
+
+    uint8_t m_latch;
+};
+
+typedef MapperDiscrete<UxROM> Mapper002;
+typedef MapperDiscrete<CNROM> Mapper003;
+typedef MapperDiscrete<AxROM> Mapper007;
+typedef MapperDiscrete<GxROM> Mapper066;
+
+}}} // nes::cart::mapper
@@ -0,0 +1,84 @@
+/*******************************************************************************
+MIT License
+
+Copyright (c) 2020 Chris Luby
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+/*******************************************************************************
+Table of the mappers linked into the program.  Each mapper registers a factory
+for its ID(s) from its own translation unit with a static Registrar, so leaving
+a mapper's object out of the link drops it from the table and the cart reports
+it as not supported.
+*******************************************************************************/
+
+#include <stdexcept>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+
+#include <utils/string_format.hpp>
+#include <nes/cart/mapper/MapperRegistry.hpp>
+
+namespace nes { namespace cart { namespace mapper {
+
+MapperRegistry &MapperRegistry::instance() {
+    // Built on first use, registrars run during static initialization
+    static MapperRegistry registry;
+    return registry;
+}
+
+/**
+ * Runs before main() so there's nothing to catch an exception (and iostreams
+ * may not be set up yet).  A clash between two linked in mappers is a build
+ * mistake, so say which ID and stop.
+ */
+void MapperRegistry::add(const uint16_t mapper_id, const Factory factory) {
+    if (!m_factories.emplace(mapper_id, factory).second) {
+        fprintf(stderr, "Mapper %u registered twice\n", mapper_id);
+        std::abort();
+    }
+}
+
+std::shared_ptr<Mapper> MapperRegistry::create(const uint16_t mapper_id, const uint8_t sub_mapper_id, std::shared_ptr<nes::cart::Cart> cart, uint16_t num_prg_banks, uint16_t num_chr_banks) const {
+    auto it = m_factories.find(mapper_id);
+    if (it == m_factories.end()) {
+        throw std::runtime_error(utils::string_format("Mapper %u not supported by this build", mapper_id));
+    }
+    return it->second(cart, num_prg_banks, num_chr_banks, sub_mapper_id);
+}
+
+const bool MapperRegistry::supported(const uint16_t mapper_id) const {
+    return m_factories.find(mapper_id) != m_factories.end();
+}
+
+std::vector<uint16_t> MapperRegistry::mapper_ids() const {
+    std::vector<uint16_t> ids;
+    for (const auto &entry : m_factories) {
+        ids.push_back(entry.first);
+    }
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+}}} // nes::cart::mapper
@@ -0,0 +1,77 @@
+/*******************************************************************************
+MIT License
+
+Copyright (c) 2020 Chris Luby
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+/*******************************************************************************
+Table of the mappers linked into the program.  Each mapper registers a factory
+for its ID(s) from its own translation unit with a static Registrar, so leaving
+a mapper's object out of the link drops it from the table and the cart reports
+it as not supported.
+*******************************************************************************/
+
+#pragma once
+
+#include <memory>
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+
+#include <nes/cart/mapper/Mapper.hpp>
+
+namespace nes { namespace cart { namespace mapper {
+
+class MapperRegistry {
+public:
+    typedef std::shared_ptr<Mapper> (*Factory)(std::shared_ptr<nes::cart::Cart> cart, uint16_t num_prg_banks, uint16_t num_chr_banks, uint8_t sub_mapper_id);
+
+    static MapperRegistry &instance();
+
+    void add(const uint16_t mapper_id, const Factory factory);
+
+    // Throws if no mapper registered mapper_id
+    std::shared_ptr<Mapper> create(const uint16_t mapper_id, const uint8_t sub_mapper_id, std::shared_ptr<nes::cart::Cart> cart, uint16_t num_prg_banks, uint16_t num_chr_banks) const;
+
+    const bool supported(const uint16_t mapper_id) const;
+    std::vector<uint16_t> mapper_ids() const;
+
+    // Factory for mappers that don't care about the sub mapper
+    template <class T>
+    static std::shared_ptr<Mapper> make(std::shared_ptr<nes::cart::Cart> cart, uint16_t num_prg_banks, uint16_t num_chr_banks, uint8_t sub_mapper_id) {
+        return std::make_shared<T>(cart, num_prg_banks, num_chr_banks);
+    }
+
+    // Declare one of these at namespace scope next to the mapper
+    class Registrar {
+    public:
+        Registrar(const uint16_t mapper_id, const Factory factory) {
+            MapperRegistry::instance().add(mapper_id, factory);
+        }
+    };
+
+private:
+    MapperRegistry() = default;
+
+    std::unordered_map<uint16_t, Factory> m_factories;
+};
+
+}}} // nes::cart::mapper
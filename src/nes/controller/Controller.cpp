@@ -23,7 +23,13 @@ SOFTWARE.
 *******************************************************************************/
 
 /*******************************************************************************
-Emulation of ram
+Emulation of the standard controllers plugged into both ports.  Writing 1 to
+0x4016 holds the shift registers loaded with the buttons, writing 0 latches
+them, and each read of 0x4016 / 0x4017 shifts out the next button of that port
+(A, B, Select, Start, Up, Down, Left, Right then all 1s).
+
+Links:
+- https://wiki.nesdev.com/w/index.php/Standard_controller
 *******************************************************************************/
 
 #include <cstdint>
@@ -35,16 +41,51 @@ Emulation of ram
 namespace nes { namespace controller {
 
 void Controller::reset() {
+    // The buttons are the player's, only the latch resets
+    std::fill(m_shift, m_shift + NUM_PORTS, 0x00);
+    m_strobe = false;
 }
 
 const bool Controller::cpu_read(const uint16_t addr, uint8_t &data, const bool read_only) {
-    data = 0x00;
+    const uint8_t port = addr - ADDR_PORT_BEGIN;
+    if (m_strobe) {
+        m_shift[port] = m_buttons[port];
+    }
+    data = OPEN_BUS | (m_shift[port] & 0x01);
 
+    // Official controllers return 1 once all the buttons are read
+    if (!read_only && !m_strobe) {
+        m_shift[port] = m_shift[port] >> 1 | 0x80;
+    }
     return true;
 }
 
 const bool Controller::cpu_write(const uint16_t addr, const uint8_t data) {
+    if (addr != ADDR_STROBE) {
+        return false;
+    }
+
+    m_strobe = (data & 0x01) != 0;
+    if (m_strobe) {
+        std::copy(m_buttons, m_buttons + NUM_PORTS, m_shift);
+    }
     return true;
 }
 
-}} // nes::controller
\ No newline at end of file
+void Controller::save_state(StateWriter &state) const {
+    state.begin("CTRL");
+    Component::save_state(state);
+    state.write(m_buttons);
+    state.write(m_shift);
+    state.write(m_strobe);
+}
+
+void Controller::load_state(StateReader &state) {
+    state.begin("CTRL");
+    Component::load_state(state);
+    state.read(m_buttons);
+    state.read(m_shift);
+    state.read(m_strobe);
+}
+
+}} // nes::controller
@@ -23,7 +23,13 @@ SOFTWARE.
 *******************************************************************************/
 
 /*******************************************************************************
-Emulation of ram
+Emulation of the standard controllers plugged into both ports.  Writing 1 to
+0x4016 holds the shift registers loaded with the buttons, writing 0 latches
+them, and each read of 0x4016 / 0x4017 shifts out the next button of that port
+(A, B, Select, Start, Up, Down, Left, Right then all 1s).
+
+Links:
+- https://wiki.nesdev.com/w/index.php/Standard_controller
 *******************************************************************************/
 
 #pragma once
@@ -37,13 +43,43 @@ namespace nes { namespace controller {
 
 class Controller : public Component {
 public:
+    // Buttons in the order they are shifted out
+    enum Button {
+        BUTTON_A = (1 << 0),
+        BUTTON_B = (1 << 1),
+        BUTTON_SELECT = (1 << 2),
+        BUTTON_START = (1 << 3),
+        BUTTON_UP = (1 << 4),
+        BUTTON_DOWN = (1 << 5),
+        BUTTON_LEFT = (1 << 6),
+        BUTTON_RIGHT = (1 << 7)
+    };
+    static const uint8_t NUM_PORTS = 2;
+
     void reset() override;
 
     const bool cpu_read(const uint16_t addr, uint8_t &data, const bool read_only = false) override;
     const bool cpu_write(const uint16_t addr, const uint8_t data) override;
 
+    // Buttons held on a port, a mask of Button
+    void set_buttons(const uint8_t port, const uint8_t buttons) {
+        m_buttons[port] = buttons;
+    }
+    const uint8_t buttons(const uint8_t port) const {
+        return m_buttons[port];
+    }
+
+    void save_state(StateWriter &state) const override;
+    void load_state(StateReader &state) override;
+
 private:
+    static const uint16_t ADDR_STROBE = 0x4016;
+    static const uint16_t ADDR_PORT_BEGIN = 0x4016;
+    static const uint8_t OPEN_BUS = 0x40; // Upper bits read back the high byte of the address
 
+    uint8_t m_buttons[NUM_PORTS] = { 0x00, 0x00 };
+    uint8_t m_shift[NUM_PORTS] = { 0x00, 0x00 };
+    bool m_strobe = false;
 };
 
-}} // nes::controller
\ No newline at end of file
+}} // nes::controller
@@ -60,15 +60,48 @@ void CPU2A03::reset() {
     m_instr_state.addr_abs = 0x0000;
     m_instr_state.addr_rel = 0x0000;
     m_instr_state.cycles = RESET_CYCLES;
+    m_stall_cycles = 0;
 
     m_disasm.clear();
     m_disasm_pc_min = UINT32_MAX;
     m_disasm_pc_max = 0;
 }
 
+void CPU2A03::save_state(StateWriter &state) const {
+    state.begin("CPU ");
+    Component::save_state(state);
+    state.write(m_reg);
+    state.write(m_instr_state.opcode);
+    state.write(m_instr_state.cycles);
+    state.write(m_instr_state.fetched);
+    state.write(m_instr_state.addr_abs);
+    state.write(m_instr_state.addr_rel);
+    state.write(m_stall_cycles);
+}
+
+void CPU2A03::load_state(StateReader &state) {
+    state.begin("CPU ");
+    Component::load_state(state);
+    state.read(m_reg);
+    state.read(m_instr_state.opcode);
+    state.read(m_instr_state.cycles);
+    state.read(m_instr_state.fetched);
+    state.read(m_instr_state.addr_abs);
+    state.read(m_instr_state.addr_rel);
+    state.read(m_stall_cycles);
+    // The decoded instruction only depends on the opcode
+    m_instr_state.instruction = INT_LOOKUP[m_instr_state.opcode];
+}
+
 void CPU2A03::clock() {
     Component::clock();
 
+    // DMA owns the bus
+    if (m_stall_cycles > 0) {
+        m_stall_cycles--;
+        return;
+    }
+
     // make sure we have used up the current instruction's cycles before moving on to the next
     if (m_instr_state.cycles == 0) {
         // std::cout << *this << std::endl;
@@ -110,12 +143,44 @@ void CPU2A03::clock() {
     m_instr_state.cycles--;
 }
 
+void CPU2A03::irq() {
+    // Maskable so only taken when interrupts are enabled
+    if (!get_status_flag(I)) {
+        interrupt(IRQ_PC_ADDR, IRQ_CYCLES);
+    }
+}
+
+void CPU2A03::nmi() {
+    interrupt(NMI_PC_ADDR, NMI_CYCLES);
+}
+
+/**
+ * Push the program counter and status to the stack and continue from the
+ * address stored at vector_addr
+ */
+void CPU2A03::interrupt(const uint16_t vector_addr, const uint8_t cycles) {
+    bus_write(STACK_BASE_ADDR + m_reg.stkp, (m_reg.pc >> 8) & 0x00FF);
+    m_reg.stkp--;
+    bus_write(STACK_BASE_ADDR + m_reg.stkp, m_reg.pc & 0x00FF);
+    m_reg.stkp--;
+
+    set_status_flag(B, false);
+    set_status_flag(U, true);
+    set_status_flag(I, true);
+    bus_write(STACK_BASE_ADDR + m_reg.stkp, m_reg.status);
+    m_reg.stkp--;
+
+    m_reg.pc = (uint16_t)bus_read(vector_addr) | ((uint16_t)bus_read(vector_addr + 1) << 8);
+
+    m_instr_state.cycles = cycles;
+}
+
 void CPU2A03::force_start_address(const uint16_t start_address) {
     m_start_address = (int32_t)start_address;
 }
 
 void CPU2A03::connect_bus(std::shared_ptr<nes::Bus> bus) {
-    m_bus = bus;
+    m_bus = bus.get();
 }
 
 uint8_t CPU2A03::bus_read(const uint16_t addr) {
@@ -65,6 +65,20 @@ public:
 	void irq(); // Interrupt Request - Executes an instruction at a specific location
 	void nmi(); // Non-Maskable Interrupt Request - As above, but cannot be disabled
 
+    // True when the current instruction has used up its cycles
+    const bool complete() const {
+        return m_instr_state.cycles == 0 && m_stall_cycles == 0;
+    }
+
+    // Halt for a number of cycles while DMA has the bus
+    void stall(const uint16_t cycles) {
+        m_stall_cycles += cycles;
+    }
+
+    // Registers and the instruction in flight
+    void save_state(StateWriter &state) const override;
+    void load_state(StateReader &state) override;
+
     // Fill out Component requirements with stubs for CPU read/write
     const bool cpu_read(const uint16_t addr, uint8_t &data, const bool read_only = false) override { return false; };
     const bool cpu_write(const uint16_t addr, const uint8_t data) override { return false; };
@@ -81,10 +95,17 @@ private:
     static const uint16_t RESET_PC_ADDR = 0xFFFC;
     static const uint8_t RESET_STKP_START = 0xFD;
     static const uint8_t RESET_CYCLES = 8;
+    static const uint16_t IRQ_PC_ADDR = 0xFFFE;
+    static const uint8_t IRQ_CYCLES = 7;
+    static const uint16_t NMI_PC_ADDR = 0xFFFA;
+    static const uint8_t NMI_CYCLES = 8;
+    static const uint16_t STACK_BASE_ADDR = 0x0100;
 
     int32_t m_start_address = -1;
 
-    std::shared_ptr<nes::Bus> m_bus;
+    uint32_t m_stall_cycles = 0;
+
+    nes::Bus *m_bus = nullptr; // The bus owns the CPU, so no reference back
     uint8_t bus_read(const uint16_t addr);
     void bus_write(const uint16_t addr, const uint8_t data);
 
@@ -132,6 +153,8 @@ private:
     uint32_t m_disasm_pc, m_disasm_pc_min, m_disasm_pc_max;
 
     void disasm_current();
+
+    void interrupt(const uint16_t vector_addr, const uint8_t cycles);
 };
 
 }} // nes::cpu
\ No newline at end of file
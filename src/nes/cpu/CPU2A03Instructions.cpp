@@ -38,6 +38,35 @@ Links:
 
 namespace nes { namespace cpu {
 
+/**
+ * Accumulator mode operates on A, every other mode on memory
+ */
+uint8_t CPU2A03Instructions::read_operand(CPU2A03 &cpu) {
+    if (cpu.m_instr_state.instruction.evaluate_address == &CPU2A03Addressing::IMP) {
+        return cpu.m_reg.a;
+    }
+    cpu.m_instr_state.fetched = cpu.bus_read(cpu.m_instr_state.addr_abs);
+    return cpu.m_instr_state.fetched;
+}
+
+/**
+ * The CPU writes the unmodified value back before the result, on the cycle
+ * before it.  Mappers such as MMC1 see both writes.
+ */
+void CPU2A03Instructions::write_result(CPU2A03 &cpu, const uint8_t old_value, const uint8_t result) {
+    if (cpu.m_instr_state.instruction.evaluate_address == &CPU2A03Addressing::IMP) {
+        cpu.m_reg.a = result;
+        return;
+    }
+    cpu.bus_write(cpu.m_instr_state.addr_abs, old_value);
+    cpu.bus_write(cpu.m_instr_state.addr_abs, result);
+}
+
+void CPU2A03Instructions::set_zero_negative(CPU2A03 &cpu, const uint8_t value) {
+    cpu.set_status_flag(CPU2A03::Z, value == 0x00);
+    cpu.set_status_flag(CPU2A03::N, (value & 0x80) != 0);
+}
+
 bool CPU2A03Instructions::ADC(CPU2A03 &cpu) {
 
     return false;
@@ -48,8 +77,15 @@ bool CPU2A03Instructions::AND(CPU2A03 &cpu) {
     return false;
 }
 
+/**
+ * Arithmetic shift left
+ */
 bool CPU2A03Instructions::ASL(CPU2A03 &cpu) {
-
+    const uint8_t value = read_operand(cpu);
+    const uint8_t result = (uint8_t)(value << 1);
+    cpu.set_status_flag(CPU2A03::C, (value & 0x80) != 0);
+    set_zero_negative(cpu, result);
+    write_result(cpu, value, result);
     return false;
 }
 
@@ -138,8 +174,14 @@ bool CPU2A03Instructions::CPY(CPU2A03 &cpu) {
     return false;
 }
 
+/**
+ * Decrement memory
+ */
 bool CPU2A03Instructions::DEC(CPU2A03 &cpu) {
-
+    const uint8_t value = read_operand(cpu);
+    const uint8_t result = (uint8_t)(value - 1);
+    set_zero_negative(cpu, result);
+    write_result(cpu, value, result);
     return false;
 }
 
@@ -158,8 +200,14 @@ bool CPU2A03Instructions::EOR(CPU2A03 &cpu) {
     return false;
 }
 
+/**
+ * Increment memory
+ */
 bool CPU2A03Instructions::INC(CPU2A03 &cpu) {
-
+    const uint8_t value = read_operand(cpu);
+    const uint8_t result = (uint8_t)(value + 1);
+    set_zero_negative(cpu, result);
+    write_result(cpu, value, result);
     return false;
 }
 
@@ -198,8 +246,15 @@ bool CPU2A03Instructions::LDY(CPU2A03 &cpu) {
     return false;
 }
 
+/**
+ * Logical shift right
+ */
 bool CPU2A03Instructions::LSR(CPU2A03 &cpu) {
-
+    const uint8_t value = read_operand(cpu);
+    const uint8_t result = value >> 1;
+    cpu.set_status_flag(CPU2A03::C, (value & 0x01) != 0);
+    set_zero_negative(cpu, result);
+    write_result(cpu, value, result);
     return false;
 }
 
@@ -233,13 +288,27 @@ bool CPU2A03Instructions::PLP(CPU2A03 &cpu) {
     return false;
 }
 
+/**
+ * Rotate left through carry
+ */
 bool CPU2A03Instructions::ROL(CPU2A03 &cpu) {
-
+    const uint8_t value = read_operand(cpu);
+    const uint8_t result = (uint8_t)((value << 1) | (cpu.get_status_flag(CPU2A03::C) ? 0x01 : 0x00));
+    cpu.set_status_flag(CPU2A03::C, (value & 0x80) != 0);
+    set_zero_negative(cpu, result);
+    write_result(cpu, value, result);
     return false;
 }
 
+/**
+ * Rotate right through carry
+ */
 bool CPU2A03Instructions::ROR(CPU2A03 &cpu) {
-
+    const uint8_t value = read_operand(cpu);
+    const uint8_t result = (value >> 1) | (cpu.get_status_flag(CPU2A03::C) ? 0x80 : 0x00);
+    cpu.set_status_flag(CPU2A03::C, (value & 0x01) != 0);
+    set_zero_negative(cpu, result);
+    write_result(cpu, value, result);
     return false;
 }
 
@@ -101,6 +101,12 @@ public:
 
 	// Unofficial
 	static bool XXX(CPU2A03 &cpu);
+
+private:
+    // Shared by the read-modify-write instructions
+    static uint8_t read_operand(CPU2A03 &cpu);
+    static void write_result(CPU2A03 &cpu, const uint8_t old_value, const uint8_t result);
+    static void set_zero_negative(CPU2A03 &cpu, const uint8_t value);
 };
 
 }} // nes::cpu
\ No newline at end of file
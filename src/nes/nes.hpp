@@ -0,0 +1,74 @@
+/*******************************************************************************
+MIT License
+
+Copyright (c) 2020 Chris Luby
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+/*******************************************************************************
+Everything a program embedding the emulator core needs, without SDL.  Build
+libnes with "make -f Makefile.linux lib" (or the mac/win makefiles) and link
+with -lnes -lz -pthread, plus -lws2_32 on Windows.
+
+A headless machine is wired up like this:
+  auto cpu = std::make_shared<nes::cpu::CPU2A03>();
+  auto bus = std::make_shared<nes::Bus>(
+      cpu, std::make_shared<nes::ram::Ram>(),
+      std::make_shared<nes::ppu::PPU2C02Headless>(),
+      std::make_shared<nes::apu::APURP2A03Headless>(),
+      std::make_shared<nes::controller::Controller>());
+  cpu->connect_bus(bus);
+  bus->load_cart(std::make_shared<nes::cart::Cart>("game.nes"));
+  bus->run_frame();
+*******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+
+#include <nes/Bus.hpp>
+#include <nes/State.hpp>
+#include <nes/Timing.hpp>
+#include <nes/cpu/CPU2A03.hpp>
+#include <nes/ram/Ram.hpp>
+#include <nes/ppu/PPU2C02.hpp>
+#include <nes/ppu/PPU2C02Headless.hpp>
+#include <nes/ppu/PPU2C02Buffer.hpp>
+#include <nes/apu/APURP2A03.hpp>
+#include <nes/apu/APURP2A03Headless.hpp>
+#include <nes/controller/Controller.hpp>
+#include <nes/cart/Cart.hpp>
+#include <nes/cart/RomDatabase.hpp>
+#include <nes/cart/mapper/MapperRegistry.hpp>
+#include <nes/Rewind.hpp>
+#include <nes/RunAhead.hpp>
+#include <nes/Movie.hpp>
+#include <nes/Batch.hpp>
+#include <nes/VecEnv.hpp>
+#include <nes/netplay/Session.hpp>
+#include <nes/netplay/LoopbackTransport.hpp>
+#include <nes/netplay/UdpTransport.hpp>
+
+namespace nes {
+
+// Bumped whenever a change to these headers breaks code built against them
+static const uint32_t API_VERSION = 1;
+
+} // nes
@@ -0,0 +1,69 @@
+/*******************************************************************************
+MIT License
+
+Copyright (c) 2020 Chris Luby
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+/*******************************************************************************
+In-process transport for testing netplay without a network.  A pair of ends
+share two queues, and a packet only shows up once the receiving end has found
+its queue empty delay more times (about once per frame), which stands in for
+network latency.
+*******************************************************************************/
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include <nes/netplay/LoopbackTransport.hpp>
+
+namespace nes { namespace netplay {
+
+std::pair<std::shared_ptr<LoopbackTransport>, std::shared_ptr<LoopbackTransport>> LoopbackTransport::create_pair(const uint32_t delay) {
+    auto a_to_b = std::make_shared<Channel>();
+    auto b_to_a = std::make_shared<Channel>();
+    // The constructor is private, so no make_shared
+    return std::make_pair(
+        std::shared_ptr<LoopbackTransport>(new LoopbackTransport(b_to_a, a_to_b, delay)),
+        std::shared_ptr<LoopbackTransport>(new LoopbackTransport(a_to_b, b_to_a, delay))
+    );
+}
+
+void LoopbackTransport::send(const uint8_t *data, const size_t size) {
+    std::lock_guard<std::mutex> lock(m_outgoing->mutex);
+    m_outgoing->packets.emplace_back(m_outgoing->polls + m_delay, std::vector<uint8_t>(data, data + size));
+}
+
+const bool LoopbackTransport::receive(std::vector<uint8_t> &data) {
+    std::lock_guard<std::mutex> lock(m_incoming->mutex);
+    if (m_incoming->packets.empty() || m_incoming->packets.front().first > m_incoming->polls) {
+        m_incoming->polls++;
+        return false;
+    }
+    data.swap(m_incoming->packets.front().second);
+    m_incoming->packets.pop_front();
+    return true;
+}
+
+}} // nes::netplay
@@ -0,0 +1,72 @@
+/*******************************************************************************
+MIT License
+
+Copyright (c) 2020 Chris Luby
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+/*******************************************************************************
+In-process transport for testing netplay without a network.  A pair of ends
+share two queues, and a packet only shows up once the receiving end has found
+its queue empty delay more times (about once per frame), which stands in for
+network latency.
+*******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include <nes/netplay/Transport.hpp>
+
+namespace nes { namespace netplay {
+
+class LoopbackTransport : public Transport {
+public:
+    // Two connected ends
+    static std::pair<std::shared_ptr<LoopbackTransport>, std::shared_ptr<LoopbackTransport>> create_pair(const uint32_t delay = 0);
+
+    void send(const uint8_t *data, const size_t size) override;
+    const bool receive(std::vector<uint8_t> &data) override;
+
+private:
+    struct Channel {
+        std::mutex mutex;
+        uint64_t polls = 0; // Times the receiver came up empty
+        std::deque<std::pair<uint64_t, std::vector<uint8_t>>> packets;
+    };
+
+    LoopbackTransport(std::shared_ptr<Channel> incoming, std::shared_ptr<Channel> outgoing, const uint32_t delay)
+        : m_incoming(incoming)
+        , m_outgoing(outgoing)
+        , m_delay(delay) {
+    }
+
+    std::shared_ptr<Channel> m_incoming;
+    std::shared_ptr<Channel> m_outgoing;
+    uint32_t m_delay;
+};
+
+}} // nes::netplay
@@ -0,0 +1,170 @@
+/*******************************************************************************
+MIT License
+
+Copyright (c) 2020 Chris Luby
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+/*******************************************************************************
+Rollback netplay between two consoles running the same ROM from power on.
+Every frame runs straight away with the local input and a guess for the remote
+one (whatever the peer pressed last).  The machine is saved at the start of each
+frame, and when the peer's real input turns out to differ from the guess, the
+session loads the save from that frame and quietly re-runs up to the present
+with output off.  It never runs more than MAX_ROLLBACK frames past the last
+frame it has the peer's input for, so a re-run is bounded.
+
+Each packet carries the sender's input for every frame the peer hasn't
+acknowledged yet, so lost packets are covered by the next one:
+  uint32 ack (last frame of the peer's input received, all ones for none)
+  uint32 first frame, uint8 count, count button masks
+
+Links:
+- https://www.ggpo.net/
+*******************************************************************************/
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <nes/netplay/Session.hpp>
+
+namespace nes { namespace netplay {
+
+namespace {
+
+void write_u32(std::vector<uint8_t> &data, const uint32_t value) {
+    for (uint32_t i = 0; i < 4; i++) {
+        data.push_back((uint8_t)(value >> (i * 8)));
+    }
+}
+
+uint32_t read_u32(const uint8_t *data) {
+    return data[0] | data[1] << 8 | data[2] << 16 | (uint32_t)data[3] << 24;
+}
+
+} // anonymous
+
+Session::Session(std::shared_ptr<nes::Bus> bus, std::shared_ptr<nes::controller::Controller> controller, std::shared_ptr<Transport> transport, const uint8_t local_port)
+    : m_bus(bus)
+    , m_controller(controller)
+    , m_transport(transport)
+    , m_local_port(local_port)
+    , m_frame(0)
+    , m_local_input()
+    , m_remote_input()
+    , m_remote_confirmed(NONE)
+    , m_remote_ack(NONE)
+    , m_rollback_frame(NONE)
+    , m_resimulated_frames(0) {
+}
+
+const bool Session::run_frame(const uint8_t buttons) {
+    receive();
+
+    // Too far past the peer's input to roll back, or to resend ours.  NONE + 1 is 0
+    if (m_frame >= m_remote_confirmed + 1 + MAX_ROLLBACK || m_frame >= m_remote_ack + HISTORY) {
+        // Keep sending while stalled so the peer hears our acks
+        send();
+        return false;
+    }
+
+    if (m_rollback_frame != NONE) {
+        m_bus->load_state(m_states[m_rollback_frame % (MAX_ROLLBACK + 1)]);
+        m_bus->set_output_enabled(false, false);
+        for (uint32_t frame = m_rollback_frame; frame < m_frame; frame++) {
+            simulate(frame);
+        }
+        m_bus->set_output_enabled(true, true);
+        m_resimulated_frames += m_frame - m_rollback_frame;
+        m_rollback_frame = NONE;
+    }
+
+    m_local_input[m_frame % HISTORY] = buttons;
+    simulate(m_frame);
+    m_frame++;
+
+    send();
+    return true;
+}
+
+void Session::simulate(const uint32_t frame) {
+    m_bus->save_state(m_states[frame % (MAX_ROLLBACK + 1)]);
+
+    // Guess the peer is still holding what they last pressed
+    if (!confirmed(frame)) {
+        m_remote_input[frame % HISTORY] = m_remote_confirmed == NONE ? 0 : m_remote_input[m_remote_confirmed % HISTORY];
+    }
+
+    m_controller->set_buttons(m_local_port, m_local_input[frame % HISTORY]);
+    m_controller->set_buttons(m_local_port ^ 1, m_remote_input[frame % HISTORY]);
+    m_bus->run_frame();
+}
+
+void Session::receive() {
+    while (m_transport->receive(m_packet)) {
+        if (m_packet.size() < HEADER_SIZE || m_packet.size() != HEADER_SIZE + m_packet[8]) {
+            continue;
+        }
+        const uint32_t ack = read_u32(&m_packet[0]);
+        const uint32_t first = read_u32(&m_packet[4]);
+
+        // Packets can arrive out of order, acks only move forward
+        if (ack != NONE && ack < m_frame && (m_remote_ack == NONE || ack > m_remote_ack)) {
+            m_remote_ack = ack;
+        }
+
+        // The sender starts at the frame after our ack, so anything new follows on
+        // from what we have unless it's an old packet arriving late
+        if (first > m_remote_confirmed + 1) {
+            continue;
+        }
+        for (uint32_t frame = m_remote_confirmed + 1; frame - first < m_packet[8]; frame++) {
+            // The peer can't legitimately get this far ahead of us
+            if (frame >= m_frame + HISTORY - MAX_ROLLBACK) {
+                break;
+            }
+            const uint8_t input = m_packet[HEADER_SIZE + frame - first];
+            if (frame < m_frame && input != m_remote_input[frame % HISTORY] && m_rollback_frame == NONE) {
+                m_rollback_frame = frame;
+            }
+            m_remote_input[frame % HISTORY] = input;
+            m_remote_confirmed = frame;
+        }
+    }
+}
+
+void Session::send() {
+    // Everything since the peer's last ack, frames first to m_frame - 1
+    const uint32_t first = m_remote_ack + 1;
+    const uint32_t count = m_frame - first;
+
+    m_packet.clear();
+    write_u32(m_packet, m_remote_confirmed);
+    write_u32(m_packet, first);
+    m_packet.push_back((uint8_t)count);
+    for (uint32_t frame = first; frame < m_frame; frame++) {
+        m_packet.push_back(m_local_input[frame % HISTORY]);
+    }
+    m_transport->send(m_packet.data(), m_packet.size());
+}
+
+}} // nes::netplay
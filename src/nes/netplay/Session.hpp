@@ -0,0 +1,111 @@
+/*******************************************************************************
+MIT License
+
+Copyright (c) 2020 Chris Luby
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+/*******************************************************************************
+Rollback netplay between two consoles running the same ROM from power on.
+Every frame runs straight away with the local input and a guess for the remote
+one (whatever the peer pressed last).  The machine is saved at the start of each
+frame, and when the peer's real input turns out to differ from the guess, the
+session loads the save from that frame and quietly re-runs up to the present
+with output off.  It never runs more than MAX_ROLLBACK frames past the last
+frame it has the peer's input for, so a re-run is bounded.
+
+Each packet carries the sender's input for every frame the peer hasn't
+acknowledged yet, so lost packets are covered by the next one:
+  uint32 ack (last frame of the peer's input received, all ones for none)
+  uint32 first frame, uint8 count, count button masks
+
+Links:
+- https://www.ggpo.net/
+*******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <nes/Bus.hpp>
+#include <nes/controller/Controller.hpp>
+#include <nes/netplay/Transport.hpp>
+
+namespace nes { namespace netplay {
+
+class Session {
+public:
+    static const uint32_t MAX_ROLLBACK = 8;
+
+    // local_port is the controller port this console plays on, the peer has the other
+    Session(std::shared_ptr<nes::Bus> bus, std::shared_ptr<nes::controller::Controller> controller, std::shared_ptr<Transport> transport, const uint8_t local_port);
+
+    // Run the next frame with the local buttons.  False if the peer has fallen
+    // too far behind, then nothing ran and the frame should be tried again.
+    const bool run_frame(const uint8_t buttons);
+
+    // Frames run so far
+    const uint32_t frame() const {
+        return m_frame;
+    }
+
+    // Frames re-run after wrong guesses, for tuning
+    const uint64_t resimulated_frames() const {
+        return m_resimulated_frames;
+    }
+
+private:
+    // Inputs are kept for a while beyond the rollback window for resending
+    static const uint32_t HISTORY = 64;
+    static const uint32_t NONE = UINT32_MAX;
+    static const size_t HEADER_SIZE = 9;
+
+    std::shared_ptr<nes::Bus> m_bus;
+    std::shared_ptr<nes::controller::Controller> m_controller;
+    std::shared_ptr<Transport> m_transport;
+    uint8_t m_local_port;
+
+    uint32_t m_frame;
+
+    uint8_t m_local_input[HISTORY];
+    uint8_t m_remote_input[HISTORY]; // Confirmed, or the guess the frame ran with
+    uint32_t m_remote_confirmed; // Last frame with all the peer's input up to it, NONE for none
+    uint32_t m_remote_ack; // Last frame of our input the peer has, NONE for none
+    uint32_t m_rollback_frame; // Earliest frame that ran with a wrong guess, NONE if none
+
+    // Machine at the start of each of the last MAX_ROLLBACK + 1 frames
+    std::vector<uint8_t> m_states[MAX_ROLLBACK + 1];
+
+    std::vector<uint8_t> m_packet;
+    uint64_t m_resimulated_frames;
+
+    void receive();
+    void send();
+    void simulate(const uint32_t frame);
+
+    const bool confirmed(const uint32_t frame) const {
+        return m_remote_confirmed != NONE && frame <= m_remote_confirmed;
+    }
+};
+
+}} // nes::netplay
@@ -0,0 +1,159 @@
+/*******************************************************************************
+MIT License
+
+Copyright (c) 2020 Chris Luby
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+/*******************************************************************************
+Netplay over UDP.  The socket is non-blocking so polling for input never stalls
+a frame, and packets from anyone but the peer are ignored.
+*******************************************************************************/
+
+#include <stdexcept>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#endif
+
+#include <utils/string_format.hpp>
+#include <nes/netplay/UdpTransport.hpp>
+
+namespace nes { namespace netplay {
+
+namespace {
+
+#ifdef _WIN32
+typedef SOCKET socket_t;
+const socket_t NO_SOCKET = INVALID_SOCKET;
+void close_socket(socket_t socket) {
+    closesocket(socket);
+}
+// Every successful WSAStartup needs a matching WSACleanup
+void stop_sockets() {
+    WSACleanup();
+}
+#else
+typedef int socket_t;
+const socket_t NO_SOCKET = -1;
+void close_socket(socket_t socket) {
+    close(socket);
+}
+void stop_sockets() {
+}
+#endif
+
+} // anonymous
+
+UdpTransport::UdpTransport(const uint16_t local_port, const std::string &remote_host, const uint16_t remote_port) {
+#ifdef _WIN32
+    WSADATA wsa_data;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0) {
+        throw std::runtime_error("Failed to start Winsock");
+    }
+#endif
+
+    // IPv4 is plenty for finding a peer
+    addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    addrinfo *result = nullptr;
+    if (getaddrinfo(remote_host.c_str(), nullptr, &hints, &result) != 0 || result == nullptr) {
+        stop_sockets();
+        throw std::runtime_error(utils::string_format("Failed to resolve netplay peer %s", remote_host.c_str()));
+    }
+    m_remote_addr = ((sockaddr_in *)result->ai_addr)->sin_addr.s_addr;
+    m_remote_port = htons(remote_port);
+    freeaddrinfo(result);
+
+    const socket_t sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock == NO_SOCKET) {
+        stop_sockets();
+        throw std::runtime_error("Failed to create a UDP socket");
+    }
+
+    sockaddr_in local = {};
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    local.sin_port = htons(local_port);
+    if (bind(sock, (sockaddr *)&local, sizeof(local)) != 0) {
+        close_socket(sock);
+        stop_sockets();
+        throw std::runtime_error(utils::string_format("Failed to bind UDP port %u", local_port));
+    }
+
+#ifdef _WIN32
+    u_long non_blocking = 1;
+    const bool blocking = ioctlsocket(sock, FIONBIO, &non_blocking) != 0;
+#else
+    const bool blocking = fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK) != 0;
+#endif
+    if (blocking) {
+        close_socket(sock);
+        stop_sockets();
+        throw std::runtime_error("Failed to make the UDP socket non-blocking");
+    }
+    m_socket = (intptr_t)sock;
+}
+
+UdpTransport::~UdpTransport() {
+    close_socket((socket_t)m_socket);
+    stop_sockets();
+}
+
+void UdpTransport::send(const uint8_t *data, const size_t size) {
+    sockaddr_in remote = {};
+    remote.sin_family = AF_INET;
+    remote.sin_addr.s_addr = m_remote_addr;
+    remote.sin_port = m_remote_port;
+    // Lost packets are the session's problem
+    sendto((socket_t)m_socket, (const char *)data, (int)size, 0, (sockaddr *)&remote, sizeof(remote));
+}
+
+const bool UdpTransport::receive(std::vector<uint8_t> &data) {
+    while (true) {
+        data.resize(MAX_PACKET_SIZE);
+        sockaddr_in from = {};
+        socklen_t from_size = sizeof(from);
+        const auto received = recvfrom((socket_t)m_socket, (char *)data.data(), (int)data.size(), 0, (sockaddr *)&from, &from_size);
+        if (received < 0) {
+            data.clear();
+            return false;
+        }
+        if (from.sin_addr.s_addr == m_remote_addr && from.sin_port == m_remote_port) {
+            data.resize((size_t)received);
+            return true;
+        }
+    }
+}
+
+}} // nes::netplay
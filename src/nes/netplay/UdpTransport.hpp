@@ -0,0 +1,61 @@
+/*******************************************************************************
+MIT License
+
+Copyright (c) 2020 Chris Luby
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+/*******************************************************************************
+Netplay over UDP.  The socket is non-blocking so polling for input never stalls
+a frame, and packets from anyone but the peer are ignored.
+*******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <nes/netplay/Transport.hpp>
+
+namespace nes { namespace netplay {
+
+class UdpTransport : public Transport {
+public:
+    // Throws std::runtime_error if the port can't be bound or the host resolved
+    UdpTransport(const uint16_t local_port, const std::string &remote_host, const uint16_t remote_port);
+    ~UdpTransport();
+
+    UdpTransport(const UdpTransport &) = delete;
+    UdpTransport &operator=(const UdpTransport &) = delete;
+
+    void send(const uint8_t *data, const size_t size) override;
+    const bool receive(std::vector<uint8_t> &data) override;
+
+private:
+    static const size_t MAX_PACKET_SIZE = 1500;
+
+    intptr_t m_socket;
+    uint32_t m_remote_addr; // Network byte order
+    uint16_t m_remote_port; // Network byte order
+};
+
+}} // nes::netplay
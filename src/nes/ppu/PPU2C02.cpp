@@ -32,6 +32,7 @@ Links:
 
 #include <iostream>
 #include <cstdint>
+#include <algorithm>
 
 #include <nes/ppu/PPU2C02.hpp>
 
@@ -39,6 +40,32 @@ namespace nes { namespace ppu {
 
 void PPU2C02::reset() {
     m_x = m_y = 0;
+    m_ctrl = 0x00;
+    m_mask = 0x00;
+    m_oam_addr = 0x00;
+    m_oam.assign(OAM_SIZE, 0x00);
+}
+
+void PPU2C02::save_state(StateWriter &state) const {
+    state.begin("PPU ");
+    Component::save_state(state);
+    state.write(m_x);
+    state.write(m_y);
+    state.write(m_ctrl);
+    state.write(m_mask);
+    state.write(m_oam.data(), OAM_SIZE);
+    state.write(m_oam_addr);
+}
+
+void PPU2C02::load_state(StateReader &state) {
+    state.begin("PPU ");
+    Component::load_state(state);
+    state.read(m_x);
+    state.read(m_y);
+    state.read(m_ctrl);
+    state.read(m_mask);
+    state.read(m_oam.writable_data(), OAM_SIZE);
+    state.read(m_oam_addr);
 }
 
 void PPU2C02::clock() {
@@ -46,15 +73,17 @@ void PPU2C02::clock() {
 
     // std::cout << "PPU.clock: " << m_x << "," << m_y << std::endl;
 
-    // If we're on the first, top-left pixel, open the screen
-    if (m_x == 0 && m_y == 0) {
-        open_screen();
-    }
+    if (m_output_enabled) {
+        // If we're on the first, top-left pixel, open the screen
+        if (m_x == 0 && m_y == 0) {
+            open_screen();
+        }
 
-    uint8_t r = m_y;
-    uint8_t g = m_x;
-    uint8_t b = m_y * m_x + m_clock_count;
-    set_pixel(m_x, m_y, r, g, b);
+        uint8_t r = m_y;
+        uint8_t g = m_x;
+        uint8_t b = m_y * m_x + m_clock_count;
+        set_pixel(m_x, m_y, r, g, b);
+    }
 
     // Each clock cycle will draw one pixel from top-left to bottom-right
     m_x++;
@@ -63,9 +92,11 @@ void PPU2C02::clock() {
         m_x = 0;
         m_y++;
         // If we are at the end of the internal screen (overscan by 22 scanlines on the bottom)...
-        if (m_y >= SCREEN_HEIGHT_INTERNAL) {
+        if (m_y >= m_scanlines) {
             m_y = 0;
-            close_screen();
+            if (m_output_enabled) {
+                close_screen();
+            }
         }
     }
 }
@@ -73,11 +104,48 @@ void PPU2C02::clock() {
 const bool PPU2C02::cpu_read(const uint16_t addr, uint8_t &data, const bool read_only) {
     data = 0x00;
 
+    // Registers are mirrored every 8 bytes
+    switch (addr & 0x0007) {
+        case ADDR_OAMDATA:
+            data = m_oam.data()[m_oam_addr];
+            break;
+    }
+
     return true;
 }
 
 const bool PPU2C02::cpu_write(const uint16_t addr, const uint8_t data) {
+    // Registers are mirrored every 8 bytes
+    switch (addr & 0x0007) {
+        case ADDR_PPUCTRL:
+            m_ctrl = data;
+            break;
+        case ADDR_PPUMASK:
+            m_mask = data;
+            break;
+        case ADDR_OAMADDR:
+            m_oam_addr = data;
+            break;
+        case ADDR_OAMDATA:
+            m_oam.writable_data()[m_oam_addr++] = data;
+            break;
+    }
+
     return true;
 }
 
+const int16_t PPU2C02::a12_rise_dot() const {
+    if ((m_mask & MASK_SHOW_RENDERING) == 0) {
+        return NO_A12_RISE;
+    }
+
+    // 8x16 sprites pick the table per sprite, assume the usual sprites at 0x1000
+    const bool sprite_high = (m_ctrl & (CTRL_SPRITE_TABLE_HIGH | CTRL_SPRITE_8X16)) != 0;
+    const bool background_high = (m_ctrl & CTRL_BACKGROUND_TABLE_HIGH) != 0;
+    if (sprite_high == background_high) {
+        return NO_A12_RISE;
+    }
+    return sprite_high ? A12_RISE_SPRITE_FETCH : A12_RISE_BACKGROUND_FETCH;
+}
+
 }} // nes::ppu
\ No newline at end of file
@@ -33,8 +33,11 @@ Links:
 #pragma once
 
 #include <cstdint>
+#include <cstring>
 
 #include <nes/Component.hpp>
+#include <nes/CowBuffer.hpp>
+#include <nes/Timing.hpp>
 
 namespace nes { namespace ppu {
 
@@ -43,7 +46,8 @@ public:
     static const int SCREEN_WIDTH = 256;
     static const int SCREEN_HEIGHT = 240;
 
-    PPU2C02() {
+    PPU2C02()
+        : m_oam(OAM_SIZE) {
     }
 
     void reset() override;
@@ -53,6 +57,59 @@ public:
     const bool cpu_read(const uint16_t addr, uint8_t &data, const bool read_only = false) override;
     const bool cpu_write(const uint16_t addr, const uint8_t data) override;
 
+    void save_state(StateWriter &state) const override;
+    void load_state(StateReader &state) override;
+
+    // PAL and Dendy consoles run 312 scanlines per frame
+    void set_timing(const nes::Timing &timing) {
+        m_scanlines = timing.scanlines;
+    }
+
+    // Speculative frames (run-ahead) aren't drawn
+    void set_output_enabled(const bool enabled) {
+        m_output_enabled = enabled;
+    }
+
+    // True right after the clock that finished the frame
+    const bool frame_complete() const {
+        return m_x == 0 && m_y == 0;
+    }
+
+    // Position of the next dot within the frame, and the number of dots in a frame
+    const uint32_t frame_dot() const {
+        return m_y * SCREEN_WIDTH_INTERNAL + m_x;
+    }
+    const uint32_t frame_dots() const {
+        return m_scanlines * SCREEN_WIDTH_INTERNAL;
+    }
+    const uint16_t scanlines() const {
+        return m_scanlines;
+    }
+
+    // Visible scanlines plus the pre-render scanline fetch pattern data
+    const bool rendering_scanline(const uint16_t scanline) const {
+        return scanline < SCREEN_HEIGHT || scanline == m_scanlines - 1;
+    }
+
+    // Dot on each rendering scanline where PPU address line A12 rises (what
+    // MMC3 counts scanlines with), worked out from PPUCTRL and PPUMASK.
+    // NO_A12_RISE if rendering is off or both fetches use the same pattern table.
+    static const int16_t NO_A12_RISE = -1;
+    const int16_t a12_rise_dot() const;
+
+    // OAM DMA writes through OAMDATA
+    void oam_dma_write(const uint8_t data) {
+        m_oam.writable_data()[m_oam_addr++] = data;
+    }
+
+    // Whole page OAM DMA, starting at OAMADDR and wrapping around
+    void oam_dma(const uint8_t *page) {
+        const uint16_t first = OAM_SIZE - m_oam_addr;
+        uint8_t *oam = m_oam.writable_data();
+        memcpy(oam + m_oam_addr, page, first);
+        memcpy(oam, page + first, OAM_SIZE - first);
+    }
+
 public: // TODO: Change to protected
     static const int SCREEN_WIDTH_INTERNAL = 341;
     static const int SCREEN_HEIGHT_INTERNAL = 262;
@@ -63,8 +120,31 @@ public: // TODO: Change to protected
 
     uint16_t m_x; // cycle
     uint16_t m_y; // scanline
+    uint16_t m_scanlines = SCREEN_HEIGHT_INTERNAL;
 
 private:
+    static const uint16_t ADDR_PPUCTRL = 0x0000;
+    static const uint16_t ADDR_PPUMASK = 0x0001;
+    static const uint16_t ADDR_OAMADDR = 0x0003;
+    static const uint16_t ADDR_OAMDATA = 0x0004;
+    static const uint16_t OAM_SIZE = 256;
+
+    static const uint8_t CTRL_SPRITE_TABLE_HIGH = 0x08;
+    static const uint8_t CTRL_BACKGROUND_TABLE_HIGH = 0x10;
+    static const uint8_t CTRL_SPRITE_8X16 = 0x20;
+    static const uint8_t MASK_SHOW_RENDERING = 0x18; // Background or sprites
+
+    // Background tiles for the next line are fetched from dot 321, sprites from 257
+    static const int16_t A12_RISE_SPRITE_FETCH = 260;
+    static const int16_t A12_RISE_BACKGROUND_FETCH = 324;
+
+    bool m_output_enabled = true;
+
+    uint8_t m_ctrl;
+    uint8_t m_mask;
+
+    CowBuffer m_oam; // Shared with forks until written
+    uint8_t m_oam_addr;
 
 };
 
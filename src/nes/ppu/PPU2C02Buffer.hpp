@@ -0,0 +1,70 @@
+/*******************************************************************************
+MIT License
+
+Copyright (c) 2020 Chris Luby
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+/*******************************************************************************
+PPU that draws straight into memory owned by someone else, 8 bit RGB row by row
+with no padding, so frames can go to the caller without a copy
+*******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include <nes/ppu/PPU2C02.hpp>
+
+namespace nes { namespace ppu {
+
+class PPU2C02Buffer : public PPU2C02 {
+public:
+    static const size_t FRAME_SIZE = SCREEN_WIDTH * SCREEN_HEIGHT * 3;
+
+    PPU2C02Buffer() : PPU2C02() {
+    };
+
+    // FRAME_SIZE bytes the following frames are drawn into, nullptr to not draw
+    void set_buffer(uint8_t *pixels) {
+        m_pixels = pixels;
+    }
+
+public: // TODO: Change to protected
+    void open_screen() override {
+    }
+    void close_screen() override {
+    }
+    void set_pixel(const int x, const int y, const uint8_t r, const uint8_t g, const uint8_t b) override {
+        if (m_pixels != nullptr && x >= 0 && x < SCREEN_WIDTH && y >= 0 && y < SCREEN_HEIGHT) {
+            uint8_t *pixel = m_pixels + (y * SCREEN_WIDTH + x) * 3;
+            pixel[0] = r;
+            pixel[1] = g;
+            pixel[2] = b;
+        }
+    }
+
+private:
+    uint8_t *m_pixels = nullptr;
+
+};
+
+}} // nes::ppu
@@ -29,6 +29,7 @@ Headless implementation of PPU
 #include <stdexcept>
 #include <cstdint>
 
+#include <utils/fnv1a.hpp>
 #include <nes/ppu/PPU2C02Headless.hpp>
 
 namespace nes { namespace ppu {
@@ -37,12 +38,17 @@ PPU2C02Headless::~PPU2C02Headless() {
 }
 
 void PPU2C02Headless::open_screen() {
+    m_hash = utils::FNV1A_64_OFFSET;
 }
 
 void PPU2C02Headless::close_screen() {
+    m_frame_hash = m_hash;
 }
 
 void PPU2C02Headless::set_pixel(const int x, const int y, const uint8_t r, const uint8_t g, const uint8_t b) {
+    if (x >= 0 && x < SCREEN_WIDTH && y >= 0 && y < SCREEN_HEIGHT) {
+        m_hash = utils::fnv1a_64(b, utils::fnv1a_64(g, utils::fnv1a_64(r, m_hash)));
+    }
 }
 
 }} // nes::ppu
\ No newline at end of file
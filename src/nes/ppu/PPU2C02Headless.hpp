@@ -23,7 +23,7 @@ SOFTWARE.
 *******************************************************************************/
 
 /*******************************************************************************
-Headless implementation of PPU
+Headless implementation of PPU that hashes each frame instead of displaying it
 *******************************************************************************/
 
 #pragma once
@@ -38,14 +38,24 @@ class PPU2C02Headless : public PPU2C02 {
 public:
     PPU2C02Headless() : PPU2C02() {
     };
+    // Carries on from where another PPU is (forking), OAM stays shared until written
+    PPU2C02Headless(const PPU2C02 &ppu) : PPU2C02(ppu) {
+    };
     ~PPU2C02Headless();
 
+    // Hash of the visible pixels of the last completed frame
+    const uint64_t frame_hash() const {
+        return m_frame_hash;
+    }
+
 public: // TODO: Change to protected
     void open_screen() override;
     void close_screen() override;
     void set_pixel(const int x, const int y, const uint8_t r, const uint8_t g, const uint8_t b) override;
 
 private:
+    uint64_t m_hash = 0;
+    uint64_t m_frame_hash = 0;
 
 };
 
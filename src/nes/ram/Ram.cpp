@@ -27,26 +27,40 @@ Emulation of ram
 *******************************************************************************/
 
 #include <cstdint>
-#include <vector>
-#include <algorithm>
 
 #include <nes/ram/Ram.hpp>
 
 namespace nes { namespace ram {
 
 void Ram::reset() {
-    m_data.resize(SIZE);
-    std::fill(m_data.begin(), m_data.begin(), 0x00);
+    if (m_data.size() != SIZE) {
+        m_data.assign(SIZE, 0x00);
+    }
 }
 
 const bool Ram::cpu_read(const uint16_t addr, uint8_t &data, const bool read_only) {
-    data = m_data[addr & (SIZE - 1)];
+    data = m_data.data()[addr & (SIZE - 1)];
     return true;
 }
 
 const bool Ram::cpu_write(const uint16_t addr, const uint8_t data) {
-    m_data[addr & (SIZE - 1)] = data;
+    m_data.writable_data()[addr & (SIZE - 1)] = data;
     return true;
 }
 
+void Ram::save_state(StateWriter &state) const {
+    state.begin("RAM ");
+    Component::save_state(state);
+    state.write(m_data.data(), SIZE);
+}
+
+void Ram::load_state(StateReader &state) {
+    state.begin("RAM ");
+    Component::load_state(state);
+    if (m_data.size() != SIZE) {
+        m_data.assign(SIZE, 0x00);
+    }
+    state.read(m_data.writable_data(), SIZE);
+}
+
 }} // nes::ram
\ No newline at end of file
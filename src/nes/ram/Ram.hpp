@@ -29,23 +29,37 @@ Emulation of ram
 #pragma once
 
 #include <cstdint>
-#include <vector>
 
 #include <nes/Component.hpp>
+#include <nes/CowBuffer.hpp>
 
 namespace nes { namespace ram {
 
 class Ram : public Component {
 public:
+    static const uint16_t SIZE = 2048;
+
     void reset() override;
 
     const bool cpu_read(const uint16_t addr, uint8_t &data, const bool read_only = false) override;
     const bool cpu_write(const uint16_t addr, const uint8_t data) override;
 
-private:
-    static const uint16_t SIZE = 2048;
+    void save_state(StateWriter &state) const override;
+    void load_state(StateReader &state) override;
 
-    std::vector<uint8_t> m_data;
+    // Direct access to the 256 byte page holding addr (pages never straddle a mirror)
+    const uint8_t *page(const uint16_t addr) const {
+        return m_data.data() + (addr & (SIZE - 1) & 0xFF00);
+    }
+
+    // The whole SIZE bytes, for observing the machine
+    const uint8_t *data() const {
+        return m_data.data();
+    }
+
+private:
+    // Copies of the RAM (forks) share it until written
+    CowBuffer m_data;
 };
 
 }} // nes::ram
\ No newline at end of file
@@ -0,0 +1,92 @@
+/*******************************************************************************
+MIT License
+
+Copyright (c) 2020 Chris Luby
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+/*******************************************************************************
+Fixed capacity queue for handing work between a producer and a consumer thread.
+Pushing blocks while the queue is full and popping blocks while it is empty.
+Items live in a ring allocated up front, so queueing never allocates.
+*******************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+
+namespace utils {
+
+template<typename T>
+class BoundedQueue {
+public:
+    BoundedQueue(const size_t capacity)
+        : m_items(capacity) {
+    }
+
+    // Returns false if the queue was closed
+    bool push(T &&item) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_not_full.wait(lock, [this] { return m_closed || m_count < m_items.size(); });
+        if (m_closed) {
+            return false;
+        }
+        m_items[(m_head + m_count) % m_items.size()] = std::move(item);
+        m_count++;
+        m_not_empty.notify_one();
+        return true;
+    }
+
+    // Returns false once the queue is closed and drained
+    bool pop(T &item) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_not_empty.wait(lock, [this] { return m_closed || m_count > 0; });
+        if (m_count == 0) {
+            return false;
+        }
+        item = std::move(m_items[m_head]);
+        m_head = (m_head + 1) % m_items.size();
+        m_count--;
+        m_not_full.notify_one();
+        return true;
+    }
+
+    // Stop accepting items, anything already queued can still be popped
+    void close() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closed = true;
+        m_not_empty.notify_all();
+        m_not_full.notify_all();
+    }
+
+private:
+    bool m_closed = false;
+    std::vector<T> m_items;
+    size_t m_head = 0;
+    size_t m_count = 0;
+    std::mutex m_mutex;
+    std::condition_variable m_not_empty;
+    std::condition_variable m_not_full;
+};
+
+} // utils
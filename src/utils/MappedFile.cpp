@@ -0,0 +1,131 @@
+/*******************************************************************************
+MIT License
+
+Copyright (c) 2020 Chris Luby
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+/*******************************************************************************
+Read-only memory mapping of a whole file.  The pages are shared with every other
+process mapping the same file and are only loaded as they are touched.
+*******************************************************************************/
+
+#include <stdexcept>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include <utils/string_format.hpp>
+#include <utils/MappedFile.hpp>
+
+namespace utils {
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string &filename) {
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error(utils::string_format("Failed to open %s for mapping", filename.c_str()));
+    }
+    m_file = file;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        throw std::runtime_error(utils::string_format("Failed to get the size of %s", filename.c_str()));
+    }
+    m_size = (size_t)size.QuadPart;
+
+    // Empty files can't be mapped, leave data as nullptr
+    if (m_size > 0) {
+        HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping == NULL) {
+            CloseHandle(file);
+            throw std::runtime_error(utils::string_format("Failed to map %s", filename.c_str()));
+        }
+        m_mapping = mapping;
+
+        m_data = (const uint8_t *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (m_data == nullptr) {
+            CloseHandle(mapping);
+            CloseHandle(file);
+            throw std::runtime_error(utils::string_format("Failed to map %s", filename.c_str()));
+        }
+    }
+}
+
+MappedFile::~MappedFile() {
+    if (m_data != nullptr) {
+        UnmapViewOfFile(m_data);
+    }
+    if (m_mapping != nullptr) {
+        CloseHandle((HANDLE)m_mapping);
+    }
+    if (m_file != nullptr) {
+        CloseHandle((HANDLE)m_file);
+    }
+}
+
+#else
+
+MappedFile::MappedFile(const std::string &filename) {
+    const int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error(utils::string_format("Failed to open %s for mapping", filename.c_str()));
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        throw std::runtime_error(utils::string_format("Failed to get the size of %s", filename.c_str()));
+    }
+    m_size = (size_t)st.st_size;
+
+    // Empty files can't be mapped, leave data as nullptr
+    if (m_size > 0) {
+        void *data = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (data == MAP_FAILED) {
+            close(fd);
+            throw std::runtime_error(utils::string_format("Failed to map %s", filename.c_str()));
+        }
+        m_data = (const uint8_t *)data;
+    }
+
+    // The mapping keeps its own reference to the file
+    close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (m_data != nullptr) {
+        munmap((void *)m_data, m_size);
+    }
+}
+
+#endif
+
+} // utils
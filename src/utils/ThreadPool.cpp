@@ -0,0 +1,159 @@
+/*******************************************************************************
+MIT License
+
+Copyright (c) 2020 Chris Luby
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+/*******************************************************************************
+Work-stealing thread pool
+*******************************************************************************/
+
+#include <cstddef>
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+#include <utils/ThreadPool.hpp>
+
+namespace utils {
+
+namespace {
+
+// Which pool and worker the current thread is, for submits from inside a task
+thread_local const ThreadPool *t_pool = nullptr;
+thread_local size_t t_worker = 0;
+
+} // anonymous
+
+ThreadPool::ThreadPool(const size_t threads)
+    : m_next_worker(0)
+    , m_queued(0)
+    , m_unfinished(0) {
+    size_t count = threads;
+    if (count == 0) {
+        count = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    }
+    for (size_t i = 0; i < count; i++) {
+        m_workers.push_back(std::make_unique<Worker>());
+    }
+    for (size_t i = 0; i < count; i++) {
+        m_threads.emplace_back(&ThreadPool::run, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_work_available.notify_all();
+    for (auto &thread : m_threads) {
+        thread.join();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    const bool from_worker = t_pool == this;
+    const size_t index = from_worker ? t_worker : m_next_worker++ % m_workers.size();
+    m_unfinished++;
+    m_queued++;
+    {
+        // Owners run from the back, so outside submits go on the front to run
+        // in the order they were made
+        std::lock_guard<std::mutex> lock(m_workers[index]->mutex);
+        if (from_worker) {
+            m_workers[index]->tasks.push_back(std::move(task));
+        } else {
+            m_workers[index]->tasks.push_front(std::move(task));
+        }
+    }
+
+    // Taking the lock orders this with a worker checking for work before sleeping
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+    }
+    m_work_available.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_all_finished.wait(lock, [this] { return m_unfinished == 0; });
+}
+
+const bool ThreadPool::take(const size_t index, std::function<void()> &task) {
+    // Newest of our own first
+    {
+        Worker &worker = *m_workers[index];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (!worker.tasks.empty()) {
+            task = std::move(worker.tasks.back());
+            worker.tasks.pop_back();
+            m_queued--;
+            return true;
+        }
+    }
+
+    // Then from the other end of someone else's
+    for (size_t i = 1; i < m_workers.size(); i++) {
+        Worker &victim = *m_workers[(index + i) % m_workers.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            m_queued--;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::run(const size_t index) {
+    t_pool = this;
+    t_worker = index;
+
+    std::function<void()> task;
+    while (true) {
+        if (take(index, task)) {
+            task();
+            task = nullptr;
+            if (--m_unfinished == 0) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_all_finished.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_work_available.wait(lock, [this] { return m_stopping || m_queued > 0; });
+        if (m_stopping && m_queued == 0) {
+            return;
+        }
+    }
+}
+
+} // utils
@@ -0,0 +1,94 @@
+/*******************************************************************************
+MIT License
+
+Copyright (c) 2020 Chris Luby
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+/*******************************************************************************
+Work-stealing thread pool.  Every worker has its own queue of tasks, runs the
+newest task from it (tasks a task submits are still hot in its cache) and when
+it runs dry steals from the other end of another worker's queue, so a few long
+jobs don't leave the other cores idle behind them.  Tasks submitted from outside
+the pool are dealt round the queues and each worker runs its share in submission
+order, so submitting the biggest jobs first starts them first and leaves the
+small ones at the end for stealing.  Tasks must not throw.
+
+Links:
+- https://en.wikipedia.org/wiki/Work_stealing
+*******************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+namespace utils {
+
+class ThreadPool {
+public:
+    // One worker per core when threads is 0
+    ThreadPool(const size_t threads = 0);
+    // Finishes every submitted task first
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // From a worker the task goes on its own queue and runs before older ones,
+    // otherwise the queues take turns and each runs its share first come first served
+    void submit(std::function<void()> task);
+
+    // Block until every task submitted so far has finished
+    void wait();
+
+    const size_t size() const {
+        return m_workers.size();
+    }
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::vector<std::thread> m_threads;
+    std::atomic<size_t> m_next_worker;
+    std::atomic<size_t> m_queued; // Waiting in a queue
+    std::atomic<size_t> m_unfinished; // Queued or running
+
+    std::mutex m_mutex;
+    std::condition_variable m_work_available;
+    std::condition_variable m_all_finished;
+    bool m_stopping = false;
+
+    const bool take(const size_t index, std::function<void()> &task);
+    void run(const size_t index);
+};
+
+} // utils
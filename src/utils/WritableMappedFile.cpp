@@ -0,0 +1,153 @@
+/*******************************************************************************
+MIT License
+
+Copyright (c) 2020 Chris Luby
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+/*******************************************************************************
+Read/write memory mapping of a whole file.  Writes land in the page cache
+straight away and reach the disk when the OS gets to them or sync() is called,
+so the file survives the process dying.  The file is created or grown to size.
+*******************************************************************************/
+
+#include <stdexcept>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include <utils/string_format.hpp>
+#include <utils/WritableMappedFile.hpp>
+
+namespace utils {
+
+#ifdef _WIN32
+
+WritableMappedFile::WritableMappedFile(const std::string &filename, const size_t size) {
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error(utils::string_format("Failed to open %s for mapping", filename.c_str()));
+    }
+    m_file = file;
+    m_size = size;
+
+    // Mapping past the end grows the file, existing bytes past size are kept
+    if (m_size > 0) {
+        LARGE_INTEGER file_size;
+        if (!GetFileSizeEx(file, &file_size)) {
+            CloseHandle(file);
+            throw std::runtime_error(utils::string_format("Failed to get the size of %s", filename.c_str()));
+        }
+        const uint64_t mapping_size = std::max<uint64_t>((uint64_t)file_size.QuadPart, m_size);
+        HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READWRITE, (DWORD)(mapping_size >> 32), (DWORD)mapping_size, NULL);
+        if (mapping == NULL) {
+            CloseHandle(file);
+            throw std::runtime_error(utils::string_format("Failed to map %s", filename.c_str()));
+        }
+        m_mapping = mapping;
+
+        m_data = (uint8_t *)MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, m_size);
+        if (m_data == nullptr) {
+            CloseHandle(mapping);
+            CloseHandle(file);
+            throw std::runtime_error(utils::string_format("Failed to map %s", filename.c_str()));
+        }
+    }
+}
+
+WritableMappedFile::~WritableMappedFile() {
+    if (m_data != nullptr) {
+        FlushViewOfFile(m_data, 0);
+        UnmapViewOfFile(m_data);
+    }
+    if (m_mapping != nullptr) {
+        CloseHandle((HANDLE)m_mapping);
+    }
+    if (m_file != nullptr) {
+        CloseHandle((HANDLE)m_file);
+    }
+}
+
+const bool WritableMappedFile::sync() {
+    if (m_data == nullptr) {
+        return true;
+    }
+    // Flushing the view only queues the writes, the file handle waits for them
+    return FlushViewOfFile(m_data, 0) && FlushFileBuffers((HANDLE)m_file);
+}
+
+#else
+
+WritableMappedFile::WritableMappedFile(const std::string &filename, const size_t size) {
+    const int fd = open(filename.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        throw std::runtime_error(utils::string_format("Failed to open %s for mapping", filename.c_str()));
+    }
+    m_size = size;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        throw std::runtime_error(utils::string_format("Failed to get the size of %s", filename.c_str()));
+    }
+
+    // Grow short files, existing bytes past size are kept
+    if ((size_t)st.st_size < m_size && ftruncate(fd, (off_t)m_size) != 0) {
+        close(fd);
+        throw std::runtime_error(utils::string_format("Failed to grow %s to %llu bytes", filename.c_str(), (unsigned long long)m_size));
+    }
+
+    // Empty mappings aren't allowed, leave data as nullptr
+    if (m_size > 0) {
+        void *data = mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (data == MAP_FAILED) {
+            close(fd);
+            throw std::runtime_error(utils::string_format("Failed to map %s", filename.c_str()));
+        }
+        m_data = (uint8_t *)data;
+    }
+
+    // The mapping keeps its own reference to the file
+    close(fd);
+}
+
+WritableMappedFile::~WritableMappedFile() {
+    if (m_data != nullptr) {
+        munmap(m_data, m_size);
+    }
+}
+
+const bool WritableMappedFile::sync() {
+    return m_data == nullptr || msync(m_data, m_size, MS_SYNC) == 0;
+}
+
+#endif
+
+} // utils
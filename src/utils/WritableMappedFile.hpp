@@ -0,0 +1,68 @@
+/*******************************************************************************
+MIT License
+
+Copyright (c) 2020 Chris Luby
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+/*******************************************************************************
+Read/write memory mapping of a whole file.  Writes land in the page cache
+straight away and reach the disk when the OS gets to them or sync() is called,
+so the file survives the process dying.  The file is created or grown to size.
+*******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+namespace utils {
+
+class WritableMappedFile {
+public:
+    // Throws std::runtime_error if the file can't be opened, grown or mapped
+    WritableMappedFile(const std::string &filename, const size_t size);
+    ~WritableMappedFile();
+
+    WritableMappedFile(const WritableMappedFile &) = delete;
+    WritableMappedFile &operator=(const WritableMappedFile &) = delete;
+
+    uint8_t *data() const {
+        return m_data;
+    }
+
+    const size_t size() const {
+        return m_size;
+    }
+
+    // Block until the dirty pages are on disk
+    const bool sync();
+
+private:
+    uint8_t *m_data = nullptr;
+    size_t m_size = 0;
+#ifdef _WIN32
+    void *m_file = nullptr;
+    void *m_mapping = nullptr;
+#endif
+};
+
+} // utils
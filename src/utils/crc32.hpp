@@ -0,0 +1,83 @@
+/*******************************************************************************
+MIT License
+
+Copyright (c) 2020 Chris Luby
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+/*******************************************************************************
+CRC-32 (IEEE 802.3, as used by zip and ROM databases) computed 8 bytes at a time
+with slicing-by-8 tables generated at compile time
+
+Links:
+- https://create.stephan-brumme.com/crc32/
+*******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace utils {
+
+const uint32_t CRC32_POLYNOMIAL = 0xEDB88320; // Reversed 0x04C11DB7
+
+struct Crc32Tables {
+    uint32_t table[8][256];
+
+    constexpr Crc32Tables() : table() {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; bit++) {
+                crc = (crc >> 1) ^ ((crc & 1) ? CRC32_POLYNOMIAL : 0);
+            }
+            table[0][i] = crc;
+        }
+        // table[n] advances a byte through n more zero bytes
+        for (uint32_t i = 0; i < 256; i++) {
+            for (int slice = 1; slice < 8; slice++) {
+                table[slice][i] = (table[slice - 1][i] >> 8) ^ table[0][table[slice - 1][i] & 0xFF];
+            }
+        }
+    }
+};
+
+inline constexpr Crc32Tables CRC32_TABLES{};
+
+// Continue from crc, so blocks can be fed in one at a time
+inline uint32_t crc32(const void *data, size_t size, uint32_t crc = 0) {
+    const uint8_t *bytes = (const uint8_t *)data;
+    const auto &t = CRC32_TABLES.table;
+
+    crc = ~crc;
+    while (size >= 8) {
+        const uint32_t one = (bytes[0] | bytes[1] << 8 | bytes[2] << 16 | (uint32_t)bytes[3] << 24) ^ crc;
+        const uint32_t two = bytes[4] | bytes[5] << 8 | bytes[6] << 16 | (uint32_t)bytes[7] << 24;
+        crc = t[7][one & 0xFF] ^ t[6][(one >> 8) & 0xFF] ^ t[5][(one >> 16) & 0xFF] ^ t[4][one >> 24]
+            ^ t[3][two & 0xFF] ^ t[2][(two >> 8) & 0xFF] ^ t[1][(two >> 16) & 0xFF] ^ t[0][two >> 24];
+        bytes += 8;
+        size -= 8;
+    }
+    while (size-- > 0) {
+        crc = (crc >> 8) ^ t[0][(crc ^ *bytes++) & 0xFF];
+    }
+    return ~crc;
+}
+
+} // utils
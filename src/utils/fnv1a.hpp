@@ -0,0 +1,56 @@
+/*******************************************************************************
+MIT License
+
+Copyright (c) 2020 Chris Luby
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+/*******************************************************************************
+64bit FNV-1a hashing, cheap enough to run over every frame and audio block
+
+Links:
+- http://www.isthe.com/chongo/tech/comp/fnv/
+*******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace utils {
+
+const uint64_t FNV1A_64_OFFSET = 0xCBF29CE484222325ULL;
+const uint64_t FNV1A_64_PRIME = 0x00000100000001B3ULL;
+
+// Continue hashing from hash, so blocks can be fed in one at a time
+inline uint64_t fnv1a_64(const void *data, const size_t size, uint64_t hash = FNV1A_64_OFFSET) {
+    const uint8_t *bytes = (const uint8_t *)data;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= FNV1A_64_PRIME;
+    }
+    return hash;
+}
+
+inline uint64_t fnv1a_64(const uint8_t byte, uint64_t hash = FNV1A_64_OFFSET) {
+    return (hash ^ byte) * FNV1A_64_PRIME;
+}
+
+} // utils